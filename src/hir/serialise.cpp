@@ -103,6 +103,16 @@
             for(const auto& i : vec)
                 serialise(i);
         }
+        // NOTE: Written identically to `std::vector`, so `deserialise_vec` can read it back
+        template<typename T, unsigned N>
+        void serialise_vec(const SmallVec<T,N>& vec)
+        {
+            TRACE_FUNCTION_F("<" << typeid(T).name() << "> size=" << vec.size());
+            auto _ = m_out.open_object(typeid(::std::vector<T>).name());
+            m_out.write_count(vec.size());
+            for(const auto& i : vec)
+                serialise(i);
+        }
         template<typename T>
         void serialise(const ::std::vector<T>& vec)
         {
@@ -10,6 +10,8 @@
 #include <hir/expr.hpp>
 #include <hir/visitor.hpp>
 #include <algorithm>
+#include <unordered_map>
+#include <sstream>
 #include <mir/mir.hpp>
 #include <hir_typeck/common.hpp>    // Monomorph
 #include <mir/helpers.hpp>
@@ -149,6 +151,8 @@ namespace MIR { namespace eval {
 
         virtual RelocPtr get_reloc(size_t ofs) const = 0;
         virtual void set_reloc(size_t ofs, RelocPtr ptr) = 0;
+        /// Append all relocations within `ofs`+`len` to `out` (with offsets relative to `ofs`)
+        virtual void read_relocs(size_t ofs, size_t len, ::std::vector<::std::pair<size_t, RelocPtr>>& out) const = 0;
     };
     /// Pointer wrapping a reference-counted allocation
     class RelocPtr
@@ -249,7 +253,7 @@ namespace MIR { namespace eval {
             if( dst_ofs != 0 )
             {
                 // Do a single-bit fill
-                while(len --)
+                for( ; len > 0; len --, dst_ofs ++)
                     dst[dst_ofs/8] |= 1 << (dst_ofs%8);
             }
             else
@@ -265,6 +269,7 @@ namespace MIR { namespace eval {
 
         RelocPtr get_reloc(size_t ofs) const override { return RelocPtr(); }
         void set_reloc(size_t ofs, RelocPtr ptr) override { abort(); }
+        void read_relocs(size_t ofs, size_t len, ::std::vector<::std::pair<size_t, RelocPtr>>& out) const override {}
 
     };
     class Allocation final: public IValue
@@ -388,14 +393,16 @@ namespace MIR { namespace eval {
                 size_t mo = ofs, ml = len;
                 for( ; mo % 8 != 0 && ml > 0; mo ++, ml --)
                     m[mo/8] |= (1 << (mo % 8));
-                for( ; ml >= 8; mo += 8, ml -= 8)
-                    m[mo/8] = 0xFF;
-                for( ; ml % 8 != 0 && ml > 0; mo ++, ml --)
+                memset(m + mo/8, 0xFF, ml / 8);
+                mo += ml & ~size_t(7);
+                ml %= 8;
+                for( ; ml > 0; mo ++, ml --)
                     m[mo/8] |= (1 << (mo % 8));
             }
-            // Clear impacted relocations
-            auto it = std::remove_if(this->relocations.begin(), this->relocations.end(), [&](const Reloc& r){ return (ofs <= r.offset && r.offset < ofs+len); });
-            this->relocations.resize( it - this->relocations.begin() );
+            // Clear impacted relocations (the list is sorted by offset)
+            auto start = this->lower_bound_reloc(ofs);
+            auto end = this->lower_bound_reloc(ofs+len);
+            this->relocations.erase(start, end);
             return this->data + ofs;
         }
         void write_mask_from(size_t ofs, const IValue& src, size_t src_ofs, size_t len) override {
@@ -406,14 +413,14 @@ namespace MIR { namespace eval {
         }
 
         RelocPtr get_reloc(size_t ofs) const override {
-            for(const auto& r : this->relocations)
-                if(r.offset == ofs)
-                    return r.ptr;
+            auto it = this->lower_bound_reloc(ofs);
+            if(it != this->relocations.end() && it->offset == ofs)
+                return it->ptr;
             return RelocPtr();
         }
         void set_reloc(size_t ofs, RelocPtr ptr) override {
             assert(ofs % (Target_GetPointerBits()/8) == 0);
-            auto it = std::lower_bound(this->relocations.begin(), this->relocations.end(), ofs, [](const Reloc& r, size_t ofs){ return r.offset < ofs; });
+            auto it = this->lower_bound_reloc(ofs);
             if(it != this->relocations.end() && it->offset == ofs) {
                 if(ptr)
                     it->ptr = std::move(ptr);
@@ -429,9 +436,20 @@ namespace MIR { namespace eval {
         }
 
 
+        void read_relocs(size_t ofs, size_t len, ::std::vector<::std::pair<size_t, RelocPtr>>& out) const override {
+            for(auto it = this->lower_bound_reloc(ofs); it != this->relocations.end() && it->offset < ofs+len; ++it)
+                out.push_back(::std::make_pair(it->offset - ofs, it->ptr));
+        }
+
         const ::HIR::TypeRef& get_type() const { return m_type; }
         const std::vector<Reloc>& get_relocations() const { return relocations; }
     private:
+        std::vector<Reloc>::iterator lower_bound_reloc(size_t ofs) {
+            return std::lower_bound(this->relocations.begin(), this->relocations.end(), ofs, [](const Reloc& r, size_t ofs){ return r.offset < ofs; });
+        }
+        std::vector<Reloc>::const_iterator lower_bound_reloc(size_t ofs) const {
+            return std::lower_bound(this->relocations.begin(), this->relocations.end(), ofs, [](const Reloc& r, size_t ofs){ return r.offset < ofs; });
+        }
               uint8_t* get_mask()       { return data + length; }
         const uint8_t* get_mask() const { return data + length; }
     };
@@ -488,7 +506,7 @@ namespace MIR { namespace eval {
             if( dst_ofs != 0 )
             {
                 // Do a single-bit fill
-                while(len --)
+                for( ; len > 0; len --, dst_ofs ++)
                     dst[dst_ofs/8] |= 1 << (dst_ofs%8);
             }
             else
@@ -513,14 +531,7 @@ namespace MIR { namespace eval {
                 for(const auto& r : m_encoded->relocations)
                 {
                     if(r.ofs == ofs) {
-                        RelocPtr    reloc;
-                        if( r.p ) {
-                            return RelocPtr(StaticRefPtr::allocate(r.p->clone(), nullptr));
-                            TODO(Span(), "Convert relocation pointer - " << *r.p);
-                        }
-                        else {
-                            return RelocPtr(AllocationPtr::allocate_ro(r.bytes.data(), r.bytes.size()));
-                        }
+                        return make_reloc(r);
                     }
                 }
             }
@@ -529,8 +540,27 @@ namespace MIR { namespace eval {
         void set_reloc(size_t ofs, RelocPtr ptr) override {
             abort();
         }
+        void read_relocs(size_t ofs, size_t len, ::std::vector<::std::pair<size_t, RelocPtr>>& out) const override {
+            if(m_encoded) {
+                for(const auto& r : m_encoded->relocations)
+                {
+                    if(ofs <= r.ofs && r.ofs < ofs+len) {
+                        out.push_back(::std::make_pair(r.ofs - ofs, make_reloc(r)));
+                    }
+                }
+            }
+        }
 
         const ::HIR::Path& path() const { return m_path; }
+    private:
+        static RelocPtr make_reloc(const ::Reloc& r) {
+            if( r.p ) {
+                return RelocPtr(StaticRefPtr::allocate(r.p->clone(), nullptr));
+            }
+            else {
+                return RelocPtr(AllocationPtr::allocate_ro(r.bytes.data(), r.bytes.size()));
+            }
+        }
     };
 #if 0   // TODO: Add this sometime?
     class InlineValue
@@ -598,10 +628,10 @@ namespace MIR { namespace eval {
             // Copy the mask data
             storage.as_value().write_mask_from(this->ofs, other.storage.as_value(), other.ofs, len);
             // Copy relocations
-            for(size_t i = 0; i < len; i ++) {
-                if(auto r = other.storage.as_value().get_reloc(other.ofs + i)) {
-                    storage.as_value().set_reloc(this->ofs + i, std::move(r));
-                }
+            ::std::vector<::std::pair<size_t, RelocPtr>>   relocs;
+            other.storage.as_value().read_relocs(other.ofs, len, relocs);
+            for(auto& r : relocs) {
+                storage.as_value().set_reloc(this->ofs + r.first, std::move(r.second));
             }
         }
 
@@ -890,6 +920,36 @@ namespace {
             TODO(sp, "Could not find function for " << path << " - " << rv.tag_str());
         }
     }
+
+    /// Cache of `const fn` call results, shared by all evaluators in this process
+    /// - Only calls that don't involve pointers (in either the arguments or the result) are cached, as those are
+    ///   fully described by their bytes. Such calls are pure, as const evaluation can't mutate global state.
+    struct ConstFnResult
+    {
+        ::std::vector<uint8_t>  bytes;
+        ::std::vector<uint8_t>  mask;
+    };
+    ::std::unordered_map<::std::string, ConstFnResult>  s_const_fn_cache;
+
+    /// Get the cache key for a call, returns an empty string if the call can't be cached
+    ::std::string get_const_fn_cache_key(const ::HIR::Path& path, ::std::vector<::MIR::eval::AllocationPtr>& args)
+    {
+        // Generic parameters have context-dependent meanings
+        if( visit_path_tys_with(path, [&](const auto& ty)->bool { return ty.data().is_Generic(); }) )
+            return ::std::string();
+        ::std::stringstream ss;
+        ss << path << '\0';
+        for(auto& a : args)
+        {
+            // NOTE: Requires fully initialised arguments, as uninitialised bytes may hold any value
+            const auto* bytes = a->get_bytes(0, a->size(), true);
+            if( !bytes || !a->get_relocations().empty() )
+                return ::std::string();
+            ss << a->size() << ":";
+            ss.write(reinterpret_cast<const char*>(bytes), a->size());
+        }
+        return ss.str();
+    }
 }   // namespace <anon>
 
 namespace HIR {
@@ -2180,7 +2240,23 @@ namespace HIR {
 
                     // TODO: Set m_const during parse and check here
 
+                    auto cache_key = get_const_fn_cache_key(fcnp, call_args);
+                    auto cache_it = cache_key.empty() ? s_const_fn_cache.end() : s_const_fn_cache.find(cache_key);
+                    if( cache_it != s_const_fn_cache.end() )
+                    {
+                        DEBUG("Cached result for " << fcnp);
+                        const auto& cached = cache_it->second;
+                        auto ret_ty = fcn_ms.monomorph_type(this->root_span, fcn.m_return);
+                        auto rv = AllocationPtr::allocate(state, ret_ty);
+                        for(size_t i = 0; i < cached.bytes.size(); i ++)
+                        {
+                            if( cached.mask[i/8] & (1 << i%8) )
+                                rv->write_bytes(i, &cached.bytes[i], 1);
+                        }
+                        dst.copy_from( state, ValueRef(rv) );
+                    }
                     // Call by invoking evaluate_constant on the function
+                    else
                     {
                         TRACE_FUNCTION_F("Call const fn " << fcnp << " args={ " << call_args << " }");
                         auto fcn_ip = ::HIR::ItemPath(fcnp);
@@ -2189,6 +2265,16 @@ namespace HIR {
                         auto ret_ty = fcn_ms.monomorph_type(this->root_span, fcn.m_return);
                         auto rv = evaluate_constant_mir(fcn_ip, *mir, mv$(fcn_ms), mv$(ret_ty), arg_defs, mv$(call_args));
                         dst.copy_from( state, ValueRef(rv) );
+
+                        if( !cache_key.empty() && rv->get_relocations().empty() )
+                        {
+                            ConstFnResult   res;
+                            const auto* bytes = rv->get_bytes(0, rv->size(), false);
+                            res.bytes.assign(bytes, bytes + rv->size());
+                            res.mask.resize( (rv->size() + 7) / 8 );
+                            rv->read_mask(res.mask.data(), 0, 0, rv->size());
+                            s_const_fn_cache.insert(::std::make_pair( mv$(cache_key), mv$(res) ));
+                        }
                     }
                 }
                 else
@@ -3652,6 +3652,9 @@ Context::IVarPossible* Context::get_ivar_possibilities(const Span& sp, unsigned
 }
 void Context::possible_equate_ivar(const Span& sp, unsigned int ivar_index, const ::HIR::TypeRef& raw_t, PossibleTypeSource src)
 {
+    if( m_possibility_log ) {
+        m_possibility_log->push_back(PossibilityRecord { PossibilityRecord::Ty::Type, sp, ivar_index, src, {}, make_vec1(raw_t.clone()) });
+    }
     const auto& t = this->m_ivars.get_type(raw_t);
     DEBUG(ivar_index << " " << src << " " << raw_t << " " << t);
     auto* entp = get_ivar_possibilities(sp, ivar_index);
@@ -3669,6 +3672,13 @@ void Context::possible_equate_ivar(const Span& sp, unsigned int ivar_index, cons
 }
 void Context::possible_equate_ivar_bounds(const Span& sp, unsigned int ivar_index, std::vector< ::HIR::TypeRef> types)
 {
+    if( m_possibility_log ) {
+        ::std::vector<::HIR::TypeRef>   types_copy;
+        types_copy.reserve(types.size());
+        for(const auto& t : types)
+            types_copy.push_back(t.clone());
+        m_possibility_log->push_back(PossibilityRecord { PossibilityRecord::Ty::Bounds, sp, ivar_index, {}, {}, mv$(types_copy) });
+    }
     // Obtain the entry (and returning early if already known)
     auto* entp = get_ivar_possibilities(sp, ivar_index);
     if(!entp)
@@ -3748,6 +3758,9 @@ std::ostream& operator<<(std::ostream& os, const Context::IvarUnknownType& x) {
 }
 void Context::possible_equate_ivar_unknown(const Span& sp, unsigned int ivar_index, IvarUnknownType src)
 {
+    if( m_possibility_log ) {
+        m_possibility_log->push_back(PossibilityRecord { PossibilityRecord::Ty::Unknown, sp, ivar_index, {}, src, {} });
+    }
     DEBUG(ivar_index << " = ?? (" << src << ")");
     ASSERT_BUG(sp, m_ivars.get_type(ivar_index).data().is_Infer(), "possible_equate_ivar_unknown on known ivar");
 
@@ -3763,6 +3776,74 @@ void Context::possible_equate_ivar_unknown(const Span& sp, unsigned int ivar_ind
     }
 }
 
+bool Context::rule_unchanged(const RuleCheckState& state, ::std::initializer_list<const ::HIR::TypeRef*> tys, const ::HIR::PathParams* params) const
+{
+    if( state.checked_at == ~0u )
+        return false;
+    if( m_ivars.values_changed_since(state.checked_at) )
+        return false;
+    struct H {
+        static bool type_changed(const HMTypeInferrence& ivars, const ::HIR::TypeRef& ty, unsigned int stamp) {
+            return visit_ty_with(ty, [&](const ::HIR::TypeRef& t)->bool {
+                TU_MATCH_HDRA( (t.data()), {)
+                default:
+                    return false;
+                TU_ARMA(Infer, e) {
+                    if( ivars.ivar_changed_since(e.index, stamp) )
+                        return true;
+                    // Also check any ivars within the type this ivar is set to
+                    const auto& real_ty = ivars.get_type(e.index);
+                    return !real_ty.data().is_Infer() && type_changed(ivars, real_ty, stamp);
+                    }
+                TU_ARMA(Closure, e) {
+                    // `visit_ty_with` doesn't recurse into closures, but `possible_equate_type_unknown` does
+                    for(const auto& a : e.node->m_args)
+                        if( type_changed(ivars, a.second, stamp) )
+                            return true;
+                    return type_changed(ivars, e.node->m_return, stamp);
+                    }
+                }
+                throw "unreachable";
+                });
+        }
+    };
+    for(const auto* ty : tys)
+    {
+        if( H::type_changed(m_ivars, *ty, state.checked_at) )
+            return false;
+    }
+    if( params )
+    {
+        for(const auto& ty : params->m_types)
+            if( H::type_changed(m_ivars, ty, state.checked_at) )
+                return false;
+    }
+    return true;
+}
+void Context::replay_possibilities(const RuleCheckState& state)
+{
+    assert(!m_possibility_log);
+    for(const auto& r : state.possibilities)
+    {
+        switch(r.ty)
+        {
+        case PossibilityRecord::Ty::Type:
+            this->possible_equate_ivar(r.sp, r.ivar_index, r.types.front(), r.src);
+            break;
+        case PossibilityRecord::Ty::Bounds: {
+            ::std::vector<::HIR::TypeRef>   types;
+            types.reserve(r.types.size());
+            for(const auto& t : r.types)
+                types.push_back(t.clone());
+            this->possible_equate_ivar_bounds(r.sp, r.ivar_index, mv$(types));
+            } break;
+        case PossibilityRecord::Ty::Unknown:
+            this->possible_equate_ivar_unknown(r.sp, r.ivar_index, r.unknown_ty);
+            break;
+        }
+    }
+}
+
 void Context::add_var(const Span& sp, unsigned int index, const RcString& name, ::HIR::TypeRef type) {
     DEBUG("(" << index << " " << name << " : " << type << ")");
     assert(index != ~0u);
@@ -7188,9 +7269,24 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
                 auto ent = mv$(context.link_coerce[i]);
                 const auto& span = (*ent->right_node_ptr)->span();
                 auto& src_ty = (*ent->right_node_ptr)->m_res_type;
+                // Worklist mode: If nothing the rule depends on has changed, the check would fail again (and register the same possibilities)
+                if( context.m_use_worklist && context.rule_unchanged(ent->check_state, { &ent->left_ty, &src_ty }) )
+                {
+                    context.replay_possibilities(ent->check_state);
+                    context.link_coerce[i] = mv$(ent);
+                    ++ i;
+                    continue ;
+                }
+                auto stamp = context.m_ivars.get_change_stamp();
                 src_ty = context.m_resolve.expand_associated_types( span, mv$(src_ty) );    // TODO: This was commented, why?
                 ent->left_ty = context.m_resolve.expand_associated_types( span, mv$(ent->left_ty) );
-                if( check_coerce(context, *ent) )
+                if( context.m_use_worklist ) {
+                    ent->check_state.possibilities.clear();
+                    context.m_possibility_log = &ent->check_state.possibilities;
+                }
+                bool consumed = check_coerce(context, *ent);
+                context.m_possibility_log = nullptr;
+                if( consumed )
                 {
                     DEBUG("- Consumed coercion R" << ent->rule_idx << " " << ent->left_ty << " := " << src_ty);
 
@@ -7198,6 +7294,7 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
                 }
                 else
                 {
+                    ent->check_state.checked_at = stamp;
                     context.link_coerce[i] = mv$(ent);
                     ++ i;
                 }
@@ -7210,6 +7307,23 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
                 auto rule = mv$(context.link_assoc[i]);
 
                 DEBUG("- " << rule);
+                if( context.m_use_worklist )
+                {
+                    if( context.rule_unchanged(rule.check_state, { &rule.left_ty, &rule.impl_ty }, &rule.params) )
+                    {
+                        DEBUG("- Unchanged");
+                        context.replay_possibilities(rule.check_state);
+                        context.link_assoc[i] = mv$(rule);
+                        i ++;
+                        if( link_assoc_iter_limit -- == 0 )
+                        {
+                            DEBUG("link_assoc iteration limit exceeded");
+                            break;
+                        }
+                        continue ;
+                    }
+                }
+                auto stamp = context.m_ivars.get_change_stamp();
                 for( auto& ty : rule.params.m_types ) {
                     ty = context.m_resolve.expand_associated_types(rule.span, mv$(ty));
                 }
@@ -7222,7 +7336,13 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
                 }
                 rule.impl_ty = context.m_resolve.expand_associated_types(rule.span, mv$(rule.impl_ty));
 
-                if( check_associated(context, rule) ) {
+                if( context.m_use_worklist ) {
+                    rule.check_state.possibilities.clear();
+                    context.m_possibility_log = &rule.check_state.possibilities;
+                }
+                bool consumed = check_associated(context, rule);
+                context.m_possibility_log = nullptr;
+                if( consumed ) {
                     DEBUG("- Consumed associated type rule " << i << "/" << context.link_assoc.size() << " - " << rule);
                     if( i != context.link_assoc.size()-1 )
                     {
@@ -7232,6 +7352,7 @@ void Typecheck_Code_CS(const typeck::ModuleState& ms, t_args& args, const ::HIR:
                     context.link_assoc.pop_back();
                 }
                 else {
+                    rule.check_state.checked_at = stamp;
                     context.link_assoc[i] = mv$(rule);
                     i ++;
                 }
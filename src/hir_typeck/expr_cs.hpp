@@ -25,6 +25,46 @@ struct Context
         virtual bool revisit(Context& context, bool is_fallback) = 0;
     };
 
+    enum class IvarUnknownType {
+        /// Coercion to an unknown type (disables 
+        To,
+        /// Coercion from an unknown type
+        From,
+        /// Bounded to be an unknown type (a strong disable)
+        Bound,
+    };
+
+    enum class PossibleTypeSource
+    {
+        CoerceTo,   //!< IVar must coerce to this type
+        UnsizeTo,   //!< IVar must unsize to this type
+        CoerceFrom,   //!< IVar must coerce from this type
+        UnsizeFrom,   //!< IVar must unsize from this type
+    };
+
+    /// A call to one of the `possible_equate_ivar*` methods, recorded so it can be replayed for an unchanged rule
+    struct PossibilityRecord
+    {
+        enum class Ty {
+            Type,   // `possible_equate_ivar`
+            Bounds, // `possible_equate_ivar_bounds`
+            Unknown,    // `possible_equate_ivar_unknown`
+        } ty;
+        Span    sp;
+        unsigned int    ivar_index;
+        PossibleTypeSource  src;
+        IvarUnknownType unknown_ty;
+        ::std::vector<::HIR::TypeRef>   types;
+    };
+    /// State used to skip re-checking rules when `m_use_worklist` is set
+    struct RuleCheckState
+    {
+        /// Ivar change stamp from before the last (failed) check, `~0u` if not yet checked
+        unsigned int    checked_at = ~0u;
+        /// Possibilities registered by the last check, replayed each pass while the rule is unchanged
+        ::std::vector<PossibilityRecord>    possibilities;
+    };
+
     struct Binding
     {
         RcString    name;
@@ -39,6 +79,8 @@ struct Context
         ::HIR::TypeRef  left_ty;
         ::HIR::ExprNodeP* right_node_ptr;
 
+        RuleCheckState  check_state;
+
         friend ::std::ostream& operator<<(::std::ostream& os, const Coercion& v) {
             os << "R" << v.rule_idx << " " << v.left_ty << " := " << v.right_node_ptr << " " << &**v.right_node_ptr << " (" << (*v.right_node_ptr)->m_res_type << ")";
             return os;
@@ -58,6 +100,8 @@ struct Context
                             // HACK: operators are special - the result when both types are primitives is ALWAYS the lefthand side
         bool    is_operator;
 
+        RuleCheckState  check_state;
+
         friend ::std::ostream& operator<<(::std::ostream& os, const Associated& v) {
             os << "R" << v.rule_idx << " ";
             if( v.name == "" ) {
@@ -150,6 +194,11 @@ struct Context
 
     const ::HIR::SimplePath m_lang_Box;
 
+    /// Only re-check coercion/associated rules when an ivar they mention has changed (set by `MRUSTC_TYPECK_WORKLIST`)
+    bool    m_use_worklist;
+    /// If non-null, all `possible_equate_ivar*` calls are recorded here (used when checking a rule in worklist mode)
+    ::std::vector<PossibilityRecord>*   m_possibility_log = nullptr;
+
     Context(
         const ::HIR::Crate& crate,
         const ::HIR::GenericParams* impl_params,
@@ -161,6 +210,7 @@ struct Context
         ,m_resolve(m_ivars, crate, impl_params, item_params, mod_path, current_trait)
         ,next_rule_idx( 0 )
         ,m_lang_Box( crate.get_lang_item_path_opt("owned_box") )
+        ,m_use_worklist( getenv("MRUSTC_TYPECK_WORKLIST") != nullptr )
     {
     }
 
@@ -196,14 +246,6 @@ struct Context
     /// Returns `nullptr` if the ivar is already known
     IVarPossible* get_ivar_possibilities(const Span& sp, unsigned int ivar_index);
 
-    enum class IvarUnknownType {
-        /// Coercion to an unknown type (disables 
-        To,
-        /// Coercion from an unknown type
-        From,
-        /// Bounded to be an unknown type (a strong disable)
-        Bound,
-    };
     /// Type is unknown (e.g. no used/results from a trait impl that can't be looked up)
     void possible_equate_type_unknown(const Span& sp, const ::HIR::TypeRef& ty, IvarUnknownType src_ty);
     /// Type must be one of the provided set
@@ -213,14 +255,6 @@ struct Context
     // IVar possibilties
     // ----
 
-    enum class PossibleTypeSource
-    {
-        CoerceTo,   //!< IVar must coerce to this type
-        UnsizeTo,   //!< IVar must unsize to this type
-        CoerceFrom,   //!< IVar must coerce from this type
-        UnsizeFrom,   //!< IVar must unsize from this type
-    };
-
     /// Default type
     //void possible_equate_ivar_def(unsigned int ivar_index, const ::HIR::TypeRef& t);
 
@@ -231,6 +265,11 @@ struct Context
     /// Record that the IVar is equated to an unknown type
     void possible_equate_ivar_unknown(const Span& sp, unsigned int ivar_index, IvarUnknownType src_ty);
 
+    /// (worklist mode) Returns true if the rule has been checked, and none of the listed types have changed since
+    bool rule_unchanged(const RuleCheckState& state, ::std::initializer_list<const ::HIR::TypeRef*> tys, const ::HIR::PathParams* params=nullptr) const;
+    /// (worklist mode) Re-apply the possibilities recorded when the rule was last checked
+    void replay_possibilities(const RuleCheckState& state);
+
     // ----
     // Patterns and bindings
     // ----
@@ -239,11 +239,13 @@ bool HMTypeInferrence::apply_defaults()
                     rv = true;
                     DEBUG("- IVar " << e->index << " = i32");
                     *v.type = ::HIR::TypeRef( ::HIR::CoreType::I32 );
+                    v.changed_at = ++ m_change_stamp;
                     break;
                 case ::HIR::InferClass::Float:
                     rv = true;
                     DEBUG("- IVar " << e->index << " = f64");
                     *v.type = ::HIR::TypeRef( ::HIR::CoreType::F64 );
+                    v.changed_at = ++ m_change_stamp;
                     break;
                 }
             }
@@ -657,6 +659,7 @@ void HMTypeInferrence::set_ivar_val_to(unsigned int slot, ::HIR::ConstGeneric va
         ASSERT_BUG(Span(), m_values[slot].val->is_Infer(), "slot " << slot << " - " << *m_values[slot].val);
         ASSERT_BUG(Span(), m_values[slot].val->as_Infer().index == slot, "slot " << slot << " - " << *m_values[slot].val);
         *m_values[slot].val = std::move(val);
+        m_values_changed_at = ++ m_change_stamp;
     }
 }
 void HMTypeInferrence::ivar_val_unify(unsigned int left_slot, unsigned int right_slot)
@@ -672,6 +675,7 @@ void HMTypeInferrence::ivar_val_unify(unsigned int left_slot, unsigned int right
         DEBUG("Set ValIVar " << right_slot << " = @" << left_slot);
         m_values[right_slot].alias = left_slot;
         m_values[right_slot].val.reset();
+        m_values_changed_at = ++ m_change_stamp;
 
         this->mark_change();
     }
@@ -746,6 +750,9 @@ void HMTypeInferrence::set_ivar_to(unsigned int slot, ::HIR::TypeRef type)
         auto& r_ivar = this->get_pointed_ivar(l_e->index);
         r_ivar.alias = slot;
         r_ivar.type.reset();
+        // NOTE: The new root is also stamped, so checking the root of an alias chain is enough to detect any change
+        r_ivar.changed_at = ++ m_change_stamp;
+        root_ivar.changed_at = m_change_stamp;
         #else
         DEBUG("Set IVar " << slot << " = @" << l_e->index);
         root_ivar.alias = l_e->index;
@@ -817,6 +824,7 @@ void HMTypeInferrence::set_ivar_to(unsigned int slot, ::HIR::TypeRef type)
         }
 
         root_ivar.type = box$( type );
+        root_ivar.changed_at = ++ m_change_stamp;
     }
 
     this->mark_change();
@@ -868,6 +876,8 @@ void HMTypeInferrence::ivar_unify(unsigned int left_slot, unsigned int right_slo
         DEBUG("IVar " << root_ivar.type->data().as_Infer().index << " = @" << left_slot);
         root_ivar.alias = left_slot;
         root_ivar.type.reset();
+        root_ivar.changed_at = ++ m_change_stamp;
+        left_ivar.changed_at = m_change_stamp;
 
         this->mark_change();
     }
@@ -1953,6 +1963,7 @@ void TraitResolution::expand_associated_types_inplace(const Span& sp, ::HIR::Typ
     {
         if( input == *ty ) {
             DEBUG("Recursive lookup, skipping - &input = " << &input);
+            m_eat_recursion_skips ++;
             return ;
         }
     }
@@ -2008,7 +2019,26 @@ void TraitResolution::expand_associated_types_inplace(const Span& sp, ::HIR::Typ
             // - Only try resolving if the binding isn't known
             if( e.binding.is_Unbound() )
             {
+                // Projections without ivars (or closures, which contain ivars) will always resolve the same way, so are cached
+                bool use_cache = !m_ivars.type_contains_ivars(input)
+                    && !visit_ty_with(input, [](const ::HIR::TypeRef& t){ return t.data().is_Closure() || t.data().is_Generator(); });
+                if( use_cache )
+                {
+                    auto it = m_aty_cache.find(input);
+                    if( it != m_aty_cache.end() )
+                    {
+                        DEBUG("Cached " << it->second);
+                        input = it->second.clone();
+                        return ;
+                    }
+                }
+                auto key = use_cache ? input.clone() : ::HIR::TypeRef();
+                auto skips = m_eat_recursion_skips;
                 this->expand_associated_types_inplace__UfcsKnown(sp, input, stack);
+                if( use_cache && skips == m_eat_recursion_skips && !m_ivars.type_contains_ivars(input) )
+                {
+                    m_aty_cache.insert(::std::make_pair( mv$(key), input.clone() ));
+                }
             }
             }
         TU_ARMA(UfcsUnknown, pe) {
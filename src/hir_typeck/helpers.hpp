@@ -60,10 +60,13 @@ public: // ?? - Needed once, anymore?
         //bool could_be_diverge;
         unsigned int alias; // If not ~0, this points to another ivar
         ::std::unique_ptr< ::HIR::TypeRef> type;    // Type (only nullptr if alias!=0)
+        /// Value of `m_change_stamp` when this ivar (or an ivar aliased to it) was last modified
+        unsigned int changed_at;
 
         IVar():
             alias(~0u),
-            type(new ::HIR::TypeRef())
+            type(new ::HIR::TypeRef()),
+            changed_at(0)
         {}
         bool is_alias() const { return alias != ~0u; }
     };
@@ -81,10 +84,16 @@ public: // ?? - Needed once, anymore?
     ::std::vector< IVarValue>    m_values;
 
     bool    m_has_changed;
+    /// Incremented on every ivar modification (used to tell if a type has changed since a given point)
+    unsigned int    m_change_stamp;
+    /// Value of `m_change_stamp` when any value ivar was last modified
+    unsigned int    m_values_changed_at;
 
 public:
     HMTypeInferrence():
-        m_has_changed(false)
+        m_has_changed(false),
+        m_change_stamp(0),
+        m_values_changed_at(0)
     {}
 
     bool peek_changed() const {
@@ -102,6 +111,19 @@ public:
         }
     }
 
+    /// Current change stamp, compare against with `ivar_changed_since`
+    unsigned int get_change_stamp() const {
+        return m_change_stamp;
+    }
+    /// Returns true if the ivar (or what it points to) has been modified since `stamp` was obtained
+    bool ivar_changed_since(unsigned int slot, unsigned int stamp) const {
+        return get_pointed_ivar(slot).changed_at > stamp;
+    }
+    /// Returns true if any value ivar has been modified since `stamp` was obtained
+    bool values_changed_since(unsigned int stamp) const {
+        return m_values_changed_at > stamp;
+    }
+
     void compact_ivars();
     bool apply_defaults();
 
@@ -180,6 +202,8 @@ class TraitResolution:
     const ::HIR::Trait* m_current_trait_ptr;
 
     mutable ::std::vector<std::unique_ptr<::HIR::TypeRef>>  m_eat_active_stack;
+    /// Count of lookups skipped due to recursion (results computed during a skip aren't cached)
+    mutable unsigned int    m_eat_recursion_skips = 0;
 public:
     TraitResolution(const HMTypeInferrence& ivars, const ::HIR::Crate& crate, const ::HIR::GenericParams* impl_params, const ::HIR::GenericParams* item_params, const ::HIR::SimplePath& vis_path,  const ::HIR::GenericPath* current_trait):
         TraitResolveCommon(crate)
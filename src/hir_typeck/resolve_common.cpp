@@ -17,6 +17,7 @@ void TraitResolveCommon::prep_indexes(const Span& sp)
 
     m_type_equalities.clear();
     m_trait_bounds.clear();
+    m_aty_cache.clear();
 
     this->iterate_bounds([&](const HIR::GenericBound& b)->bool {
         TU_MATCH_HDRA( (b), { )
@@ -65,6 +65,10 @@ struct TraitResolveCommon
     typedef RangeVecMap< std::pair< ::HIR::TypeRef, ::HIR::GenericPath>, CachedBound, CachedBoundCmp> cached_bounds_t;
     cached_bounds_t m_trait_bounds;
 
+    /// Resolved associated type projections (`<T as Trait<P>>::Name` type to result)
+    /// - Only contains projections without ivars, cleared by `prep_indexes` as results depend on the bounds
+    mutable ::std::map< ::HIR::TypeRef, ::HIR::TypeRef> m_aty_cache;
+
     ::HIR::SimplePath   m_lang_Copy;
     ::HIR::SimplePath   m_lang_Clone;   // 1.29
     ::HIR::SimplePath   m_lang_Drop;
@@ -1350,8 +1350,7 @@ void StaticTraitResolve::expand_associated_types_inner(const Span& sp, ::HIR::Ty
             // - Only try resolving if the binding isn't known
             if( !e.binding.is_Unbound() )
                 return ;
-            auto k = FMT(e.path);
-            auto it = m_aty_cache.find(k);
+            auto it = m_aty_cache.find(input);
             if( it != m_aty_cache.end() )
             {
                 DEBUG("Cached " << it->second);
@@ -1359,6 +1358,7 @@ void StaticTraitResolve::expand_associated_types_inner(const Span& sp, ::HIR::Ty
             }
             else
             {
+                auto k = input.clone();
                 this->expand_associated_types__UfcsKnown(sp, input);
                 m_aty_cache.insert(std::make_pair( std::move(k), input.clone() ));
             }
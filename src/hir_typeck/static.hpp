@@ -40,7 +40,6 @@ class StaticTraitResolve:
     mutable ::std::map< ::HIR::TypeRef, bool >  m_copy_cache;
     mutable ::std::map< ::HIR::TypeRef, bool >  m_clone_cache;
     mutable ::std::map< ::HIR::TypeRef, bool >  m_drop_cache;
-    mutable ::std::map< std::string, HIR::TypeRef>  m_aty_cache;
 
 public:
     explicit StaticTraitResolve(const ::HIR::Crate& crate):
@@ -53,7 +52,6 @@ private:
         m_copy_cache.clear();
         m_clone_cache.clear();
         m_drop_cache.clear();
-        m_aty_cache.clear();
         TraitResolveCommon::prep_indexes(Span());
     }
 public:
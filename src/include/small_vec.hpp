@@ -0,0 +1,243 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * include/small_vec.hpp
+ * - Vector with inline storage for a small number of (trivially copyable) items
+ */
+#pragma once
+
+#include <algorithm>  // max/copy/equal
+#include <cassert>
+#include <cstdint>
+#include <cstring>  // memcpy/memmove
+#include <iterator>
+#include <initializer_list>
+#include <new>  // operator new/delete
+#include <stdexcept>    // std::out_of_range
+#include <type_traits>
+#include <vector>
+#include "../common.hpp"    // Ordering
+
+/// Vector that stores up to `N` items inline before spilling to the heap
+///
+/// Only supports trivially copyable types (items are moved with memcpy), and exposes raw pointers as iterators.
+template<typename T, unsigned N>
+class SmallVec
+{
+    static_assert(::std::is_trivially_copyable<T>::value, "SmallVec requires a trivially copyable type");
+    static_assert(N > 0, "SmallVec requires a non-zero inline capacity");
+
+    uint32_t    m_size;
+    /// Current capacity, equal to `N` when the inline buffer is in use
+    uint32_t    m_cap;
+    union {
+        alignas(T) unsigned char    m_inline[N * sizeof(T)];
+        T*  m_heap;
+    };
+public:
+    typedef T   value_type;
+    typedef T*  iterator;
+    typedef const T*    const_iterator;
+    typedef ::std::reverse_iterator<iterator>   reverse_iterator;
+    typedef ::std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    SmallVec():
+        m_size(0),
+        m_cap(N)
+    {
+    }
+    SmallVec(::std::initializer_list<T> items):
+        SmallVec()
+    {
+        insert(end(), items.begin(), items.end());
+    }
+    template<typename It>
+    SmallVec(It begin_it, It end_it):
+        SmallVec()
+    {
+        insert(end(), begin_it, end_it);
+    }
+    SmallVec(const ::std::vector<T>& v):
+        SmallVec(v.begin(), v.end())
+    {
+    }
+    SmallVec(const SmallVec& x):
+        SmallVec()
+    {
+        reserve(x.m_size);
+        ::std::memcpy(static_cast<void*>(data()), x.data(), x.m_size * sizeof(T));
+        m_size = x.m_size;
+    }
+    SmallVec(SmallVec&& x):
+        SmallVec()
+    {
+        steal(x);
+    }
+    SmallVec& operator=(const SmallVec& x)
+    {
+        if( this != &x )
+        {
+            m_size = 0;
+            reserve(x.m_size);
+            ::std::memcpy(static_cast<void*>(data()), x.data(), x.m_size * sizeof(T));
+            m_size = x.m_size;
+        }
+        return *this;
+    }
+    SmallVec& operator=(SmallVec&& x)
+    {
+        if( this != &x )
+        {
+            release();
+            steal(x);
+        }
+        return *this;
+    }
+    ~SmallVec()
+    {
+        release();
+    }
+
+    bool is_inline() const { return m_cap == N; }
+
+          T* data()       { return is_inline() ? reinterpret_cast<      T*>(m_inline) : m_heap; }
+    const T* data() const { return is_inline() ? reinterpret_cast<const T*>(m_inline) : m_heap; }
+
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_cap; }
+    bool empty() const { return m_size == 0; }
+
+    iterator begin() { return data(); }
+    iterator end()   { return data() + m_size; }
+    const_iterator begin() const { return data(); }
+    const_iterator end()   const { return data() + m_size; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend()   { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend()   const { return const_reverse_iterator(begin()); }
+
+          T& operator[](size_t i)       { assert(i < m_size); return data()[i]; }
+    const T& operator[](size_t i) const { assert(i < m_size); return data()[i]; }
+          T& at(size_t i)       { if(i >= m_size) throw ::std::out_of_range("SmallVec::at"); return data()[i]; }
+    const T& at(size_t i) const { if(i >= m_size) throw ::std::out_of_range("SmallVec::at"); return data()[i]; }
+          T& front()       { assert(m_size > 0); return data()[0]; }
+    const T& front() const { assert(m_size > 0); return data()[0]; }
+          T& back()       { assert(m_size > 0); return data()[m_size-1]; }
+    const T& back() const { assert(m_size > 0); return data()[m_size-1]; }
+
+    void reserve(size_t n)
+    {
+        if( n <= m_cap )
+            return ;
+        size_t new_cap = ::std::max(n, static_cast<size_t>(m_cap) * 2);
+        T* new_data = static_cast<T*>(::operator new(new_cap * sizeof(T)));
+        ::std::memcpy(static_cast<void*>(new_data), data(), m_size * sizeof(T));
+        if( !is_inline() )
+            ::operator delete(m_heap);
+        m_heap = new_data;
+        m_cap = static_cast<uint32_t>(new_cap);
+    }
+    void clear()
+    {
+        m_size = 0;
+    }
+
+    void push_back(T v)
+    {
+        reserve(m_size + 1);
+        data()[m_size] = v;
+        m_size += 1;
+    }
+    void pop_back()
+    {
+        assert(m_size > 0);
+        m_size -= 1;
+    }
+
+    iterator insert(const_iterator pos, T v)
+    {
+        size_t idx = pos - begin();
+        assert(idx <= m_size);
+        reserve(m_size + 1);
+        T* p = data() + idx;
+        ::std::memmove(static_cast<void*>(p + 1), p, (m_size - idx) * sizeof(T));
+        *p = v;
+        m_size += 1;
+        return p;
+    }
+    /// Insert a range of items (which must not be from this vector)
+    template<typename It>
+    iterator insert(const_iterator pos, It begin_it, It end_it)
+    {
+        size_t idx = pos - begin();
+        assert(idx <= m_size);
+        size_t count = ::std::distance(begin_it, end_it);
+        reserve(m_size + count);
+        T* p = data() + idx;
+        ::std::memmove(static_cast<void*>(p + count), p, (m_size - idx) * sizeof(T));
+        ::std::copy(begin_it, end_it, p);
+        m_size += static_cast<uint32_t>(count);
+        return p;
+    }
+    iterator erase(const_iterator pos)
+    {
+        return erase(pos, pos + 1);
+    }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        size_t idx = first - begin();
+        size_t count = last - first;
+        assert(idx + count <= m_size);
+        T* p = data() + idx;
+        ::std::memmove(static_cast<void*>(p), p + count, (m_size - idx - count) * sizeof(T));
+        m_size -= static_cast<uint32_t>(count);
+        return p;
+    }
+
+    bool operator==(const SmallVec& x) const {
+        return m_size == x.m_size && ::std::equal(begin(), end(), x.begin());
+    }
+    bool operator!=(const SmallVec& x) const {
+        return !(*this == x);
+    }
+
+private:
+    void release()
+    {
+        if( !is_inline() )
+            ::operator delete(m_heap);
+        m_size = 0;
+        m_cap = N;
+    }
+    /// Take the contents of `x` (which is left empty), assumes that `this` is empty and inline
+    void steal(SmallVec& x)
+    {
+        if( x.is_inline() ) {
+            ::std::memcpy(m_inline, x.m_inline, x.m_size * sizeof(T));
+        }
+        else {
+            m_heap = x.m_heap;
+            m_cap = x.m_cap;
+        }
+        m_size = x.m_size;
+        x.m_size = 0;
+        x.m_cap = N;
+    }
+};
+
+template<typename T, unsigned N>
+Ordering ord(const SmallVec<T,N>& l, const SmallVec<T,N>& r)
+{
+    for(size_t i = 0; i < l.size(); i ++)
+    {
+        if( i >= r.size() )
+            return OrdGreater;
+        auto rv = ::ord(l[i], r[i]);
+        if( rv != OrdEqual )
+            return rv;
+    }
+    if( l.size() < r.size() )
+        return OrdLess;
+    return OrdEqual;
+}
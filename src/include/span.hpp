@@ -10,6 +10,7 @@
 #include <rc_string.hpp>
 #include <functional>
 #include <memory>
+#include <cstdint>
 
 enum ErrorType
 {
@@ -30,44 +31,27 @@ struct ProtoSpan
     unsigned int start_line;
     unsigned int start_ofs;
 };
+/// Handle to a source span
+///
+/// Spans are stored in a global append-only (and de-duplicated) table, so this is just a 32-bit index that can be
+/// freely copied without any reference counting.
 struct Span
 {
 private:
-    SpanInner*  m_ptr;
-    static SpanInner    s_empty_span;
+    /// Index into the span table, zero is the empty span
+    uint32_t    m_idx;
 public:
     Span():
-        m_ptr(&s_empty_span)
+        m_idx(0)
     {}
     Span(Span parent, RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs);
     Span(Span parent, const Position& position);
-    ~Span();
 
-    Span(const Span& x);
-    Span(Span&& x):
-        m_ptr(x.m_ptr)
-    {
-        x.m_ptr = nullptr;
-    }
-
-    Span& operator=(const Span& x)
-    {
-        this->~Span();
-        new (this) Span(x);
-        return *this;
-    }
-    Span& operator=(Span&& x)
-    {
-        this->~Span();
-        new (this) Span(std::move(x));
-        return *this;
-    }
-
-    bool operator==(const Span& x) const { return m_ptr == x.m_ptr; }
+    bool operator==(const Span& x) const { return m_idx == x.m_idx; }
     bool operator!=(const Span& x) const { return !(*this == x); }
 
-    const SpanInner& operator*() const { return *m_ptr; }
-    const SpanInner* operator->() const { return m_ptr; }
+    const SpanInner& operator*() const;
+    const SpanInner* operator->() const { return &**this; }
 
     void bug(::std::function<void(::std::ostream&)> msg) const;
     void error(ErrorType tag, ::std::function<void(::std::ostream&)> msg) const;
@@ -78,10 +62,6 @@ public:
 };
 struct SpanInner
 {
-    friend struct Span;
-private:
-    size_t  reference_count;
-public:
     Span    parent_span;
     RcString    filename;
 
@@ -89,19 +69,6 @@ public:
     unsigned int start_ofs;
     unsigned int end_line;
     unsigned int end_ofs;
-
-private:
-    static SpanInner* alloc(Span parent, RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs) {
-        auto* rv = new SpanInner();
-        rv->reference_count = 1;
-        rv->parent_span = parent;
-        rv->filename = ::std::move(filename);
-        rv->start_line = start_line;
-        rv->start_ofs = start_ofs;
-        rv->end_line = end_line;
-        rv->end_ofs = end_ofs;
-        return rv;
-    }
 };
 
 template<typename T>
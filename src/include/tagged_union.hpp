@@ -19,6 +19,7 @@
 #include <cassert>
 #include <string>
 #include <stdexcept>
+#include <type_traits>
 
 #define TU_FIRST(a, ...)    a
 #define TU_EXP1(x)  x
@@ -188,6 +189,10 @@
 */
 #define TU_UNION_FIELDS(...)    TU_EXP1( TU_GMX(__VA_ARGS__)(TU_UNION_FIELD,__VA_ARGS__) )
 
+// List of variant types (with a leading comma)
+#define TU_TYPE_ENT(tag, ...)   , TU_DATANAME(tag)
+#define TU_TYPE_LIST(...)   TU_EXP1( TU_GMX(__VA_ARGS__)(TU_TYPE_ENT,__VA_ARGS__) )
+
 #define TU_CONSS(_name, ...) TU_EXP1( TU_GMA(__VA_ARGS__)(TU_CONS, (_name), __VA_ARGS__) )
 #define TU_TYPEDEFS(...)     TU_EXP1( TU_GMX(__VA_ARGS__)(TU_TYPEDEF   ,__VA_ARGS__) )
 #define TU_TAGS(...)         TU_EXP1( TU_GMX(__VA_ARGS__)(TU_TAG       ,__VA_ARGS__) )
@@ -232,12 +237,16 @@ class _name TU_EXP _inherit { \
 */ private:\
     Tag m_tag; \
     union DataUnion { TU_UNION_FIELDS _variants DataUnion() {} ~DataUnion() {} } m_data;/*
+*/  /* If all variants are trivially copyable, destruction is a no-op (no dispatch on the tag). Moves copy only the active variant, as a whole-storage copy would read uninitialised bytes */\
+    enum { tu_is_trivial = TU_all_trivial<int TU_TYPE_LIST _variants>::value };/*
+*/  void tu_move_data(_name& x) { switch(m_tag) { case TAGDEAD: break; TU_MOVE_CASES _variants } }/*
+*/  void tu_destroy_data() { if(!tu_is_trivial) { switch(m_tag) { case TAGDEAD: break; TU_DEST_CASES _variants } } }/*
 */ public:\
     _name(): m_tag(TAG_##_def) { new (&m_data._def) TU_DATANAME(_def)(); }/*
 */  _name(const _name&) = delete;/*
-*/  _name(_name&& x) noexcept: m_tag(x.m_tag) TU_EXP _extra_move { switch(m_tag) { case TAGDEAD: break; TU_MOVE_CASES _variants } x.m_tag = TAGDEAD; }/*
-*/  _name& operator =(_name&& x) { switch(m_tag) { case TAGDEAD: break; TU_DEST_CASES _variants } m_tag = x.m_tag; TU_EXP _extra_assign switch(m_tag) { case TAGDEAD: break; TU_MOVE_CASES _variants }; return *this; }/*
-*/  ~_name() { switch(m_tag) { case TAGDEAD: break; TU_DEST_CASES _variants } m_tag = TAGDEAD; } \
+*/  _name(_name&& x) noexcept: m_tag(x.m_tag) TU_EXP _extra_move { tu_move_data(x); x.m_tag = TAGDEAD; }/*
+*/  _name& operator =(_name&& x) { tu_destroy_data(); m_tag = x.m_tag; TU_EXP _extra_assign tu_move_data(x); return *this; }/*
+*/  ~_name() { tu_destroy_data(); m_tag = TAGDEAD; } \
     \
     Tag tag() const { return m_tag; }\
     const char* tag_str() const { return tag_to_str(m_tag); }\
@@ -263,6 +272,13 @@ class _name TU_EXP _inherit { \
 namespace {
     template<typename T> static void TU_destruct_inplace(T& v) { v.~T(); }
 }
+template<typename... Ts> struct TU_all_trivial;
+template<> struct TU_all_trivial<> {
+    static const bool value = true;
+};
+template<typename T, typename... Ts> struct TU_all_trivial<T, Ts...> {
+    static const bool value = ::std::is_trivially_copyable<T>::value && TU_all_trivial<Ts...>::value;
+};
 
 
 #endif
@@ -845,6 +845,8 @@ int main(int argc, char *argv[])
         CompilePhaseV("Trans Monomorph", [&]() { Trans_Monomorphise_List(*hir_crate, items); });
         // - Do post-monomorph inlining
         CompilePhaseV("MIR Optimise Inline", [&]() { MIR_OptimiseCrate_Inlining(*hir_crate, items); });
+        // - Merge functions that ended up with identical code
+        CompilePhaseV("Trans Deduplicate", [&]() { Trans_Deduplicate(*hir_crate, items); });
         // - Clean up no-unused functions
         CompilePhaseV("Trans Enumerate Cleanup", [&]() { Trans_Enumerate_Cleanup(*hir_crate, items); });
 
@@ -0,0 +1,267 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * mir/dataflow.cpp
+ * - Block-level dataflow analysis of MIR locals (using dense bitsets)
+ */
+#include "dataflow.hpp"
+#include "helpers.hpp"
+#include <mir/mir.hpp>
+#include <algorithm>    // ::std::none_of, ::std::min
+
+bool ::MIR::LocalBitSet::union_with(const LocalBitSet& x)
+{
+    assert(m_words.size() == x.m_words.size());
+    bool changed = false;
+    for(size_t i = 0; i < m_words.size(); i ++)
+    {
+        auto v = m_words[i] | x.m_words[i];
+        if( v != m_words[i] ) {
+            m_words[i] = v;
+            changed = true;
+        }
+    }
+    return changed;
+}
+void ::MIR::LocalBitSet::subtract(const LocalBitSet& x)
+{
+    assert(m_words.size() == x.m_words.size());
+    for(size_t i = 0; i < m_words.size(); i ++)
+    {
+        m_words[i] &= ~x.m_words[i];
+    }
+}
+
+namespace
+{
+    using ::MIR::visit::ValUsage;
+
+    template<typename Cb>
+    void mark_lvalue_used(const ::MIR::LValue& lv, Cb& cb)
+    {
+        if( lv.m_root.is_Local() )
+            cb(lv.m_root.as_Local());
+        for(const auto& w : lv.m_wrappers)
+            if( w.is_Index() )
+                cb(w.as_Index());
+    }
+
+    /// Enumerate the locals defined (fully overwritten) and used by a statement
+    /// - Only plain assignments count as definitions, other writes (e.g. asm outputs) are neither uses nor definitions
+    template<typename DefCb, typename UseCb>
+    void visit_use_def(const ::MIR::Statement& stmt, DefCb def_cb, UseCb use_cb)
+    {
+        if( const auto* se = stmt.opt_Assign() )
+        {
+            if( se->dst.is_Local() ) {
+                def_cb(se->dst.as_Local());
+            }
+            else {
+                // Partial write, the rest of the local is still needed
+                mark_lvalue_used(se->dst, use_cb);
+            }
+            ::MIR::visit::visit_mir_lvalues(se->src, [&](const ::MIR::LValue& lv, ValUsage ) {
+                mark_lvalue_used(lv, use_cb);
+                return false;
+                });
+        }
+        else
+        {
+            ::MIR::visit::visit_mir_lvalues(stmt, [&](const ::MIR::LValue& lv, ValUsage vu) {
+                if( !(vu == ValUsage::Write && lv.is_Local()) )
+                    mark_lvalue_used(lv, use_cb);
+                return false;
+                });
+        }
+    }
+    template<typename UseCb>
+    void visit_uses(const ::MIR::Terminator& term, UseCb use_cb)
+    {
+        // NOTE: The return value of a call isn't treated as a definition, as it's only written on one of the two edges
+        ::MIR::visit::visit_mir_lvalues(term, [&](const ::MIR::LValue& lv, ValUsage vu) {
+            if( !(vu == ValUsage::Write && lv.is_Local()) )
+                mark_lvalue_used(lv, use_cb);
+            return false;
+            });
+    }
+}
+
+void ::MIR::LocalLiveness::step_back(const Statement& stmt, LocalBitSet& live) const
+{
+    // Definitions are applied first, so `_1 = _1 + 1` leaves `_1` live
+    visit_use_def(stmt, [&](unsigned idx){ live.reset(idx); }, [](unsigned){});
+    visit_use_def(stmt, [](unsigned){}, [&](unsigned idx){ live.set(idx); });
+    live.union_with(this->borrowed);
+}
+void ::MIR::LocalLiveness::step_back(const Terminator& term, LocalBitSet& live) const
+{
+    visit_uses(term, [&](unsigned idx){ live.set(idx); });
+    live.union_with(this->borrowed);
+}
+
+::MIR::LocalLiveness MIR_Helper_GetLiveness(::MIR::TypeResolve& state, const ::MIR::Function& fcn)
+{
+    TRACE_FUNCTION_F(state);
+    const size_t n_locals = fcn.locals.size();
+    const size_t n_blocks = fcn.blocks.size();
+
+    ::MIR::LocalLiveness    rv;
+    rv.borrowed = ::MIR::LocalBitSet(n_locals);
+
+    // - Locate borrowed locals (borrows through a deref don't borrow the local itself)
+    {
+        auto cb = [&](const ::MIR::LValue& lv, ValUsage vu) {
+            if( vu == ValUsage::Borrow && lv.m_root.is_Local() ) {
+                if( ::std::none_of(lv.m_wrappers.begin(), lv.m_wrappers.end(), [](const ::MIR::LValue::Wrapper& w){ return w.is_Deref(); }) )
+                    rv.borrowed.set(lv.m_root.as_Local());
+            }
+            return false;
+            };
+        for(const auto& bb : fcn.blocks)
+        {
+            for(const auto& stmt : bb.statements)
+                ::MIR::visit::visit_mir_lvalues(stmt, cb);
+            ::MIR::visit::visit_mir_lvalues(bb.terminator, cb);
+        }
+    }
+
+    // - Summarise each block as the set of locals used before being defined, and the set defined
+    ::std::vector<::MIR::LocalBitSet>   block_use(n_blocks, ::MIR::LocalBitSet(n_locals));
+    ::std::vector<::MIR::LocalBitSet>   block_def(n_blocks, ::MIR::LocalBitSet(n_locals));
+    ::std::vector<::std::vector<unsigned>>  preds(n_blocks);
+    for(size_t bb_idx = 0; bb_idx < n_blocks; bb_idx ++)
+    {
+        const auto& bb = fcn.blocks[bb_idx];
+        auto& use = block_use[bb_idx];
+        auto& def = block_def[bb_idx];
+        visit_uses(bb.terminator, [&](unsigned idx){ use.set(idx); });
+        for(size_t i = bb.statements.size(); i --; )
+        {
+            visit_use_def(bb.statements[i], [&](unsigned idx){ def.set(idx); use.reset(idx); }, [](unsigned){});
+            visit_use_def(bb.statements[i], [](unsigned){}, [&](unsigned idx){ use.set(idx); });
+        }
+        ::MIR::visit::visit_terminator_target(bb.terminator, [&](const ::MIR::BasicBlockId& tgt) {
+            if( preds[tgt].empty() || preds[tgt].back() != bb_idx )
+                preds[tgt].push_back(bb_idx);
+            });
+    }
+
+    // - Backwards worklist iteration until the live-in sets stabilise
+    rv.live_in.resize(n_blocks, ::MIR::LocalBitSet(n_locals));
+    rv.live_out.resize(n_blocks, ::MIR::LocalBitSet(n_locals));
+    ::std::vector<unsigned> worklist;
+    ::std::vector<bool> queued(n_blocks, true);
+    worklist.reserve(n_blocks);
+    for(size_t i = 0; i < n_blocks; i ++)
+        worklist.push_back(i);  // Popped from the back, so later blocks are visited first
+    size_t n_visits = 0;
+    while( !worklist.empty() )
+    {
+        auto bb_idx = worklist.back();
+        worklist.pop_back();
+        queued[bb_idx] = false;
+        n_visits ++;
+
+        auto& out = rv.live_out[bb_idx];
+        ::MIR::visit::visit_terminator_target(fcn.blocks[bb_idx].terminator, [&](const ::MIR::BasicBlockId& tgt) {
+            out.union_with(rv.live_in[tgt]);
+            });
+
+        auto in = out;
+        in.subtract(block_def[bb_idx]);
+        in.union_with(block_use[bb_idx]);
+        in.union_with(rv.borrowed);
+        if( in != rv.live_in[bb_idx] )
+        {
+            rv.live_in[bb_idx] = ::std::move(in);
+            for(auto p : preds[bb_idx])
+            {
+                if( !queued[p] ) {
+                    queued[p] = true;
+                    worklist.push_back(p);
+                }
+            }
+        }
+    }
+    DEBUG(n_blocks << " blocks, " << n_locals << " locals, " << n_visits << " block visits");
+
+    return rv;
+}
+
+::std::vector<bool> MIR_Helper_GetCyclicBlocks(const ::MIR::Function& fcn)
+{
+    // Tarjan's strongly connected components algorithm, iterative as functions can have many thousands of blocks
+    const size_t n_blocks = fcn.blocks.size();
+    ::std::vector<bool> rv(n_blocks);
+    ::std::vector<::std::vector<unsigned>>  succs(n_blocks);
+    for(size_t bb_idx = 0; bb_idx < n_blocks; bb_idx ++)
+    {
+        ::MIR::visit::visit_terminator_target(fcn.blocks[bb_idx].terminator, [&](const ::MIR::BasicBlockId& tgt) {
+            // A self-loop is a single-block cycle
+            if( tgt == bb_idx )
+                rv[bb_idx] = true;
+            succs[bb_idx].push_back(tgt);
+            });
+    }
+
+    const unsigned UNVISITED = ~0u;
+    ::std::vector<unsigned> index(n_blocks, UNVISITED);
+    ::std::vector<unsigned> lowlink(n_blocks);
+    ::std::vector<bool> on_stack(n_blocks);
+    ::std::vector<unsigned> scc_stack;
+    // Emulated call stack: (block, index of the next successor to visit)
+    ::std::vector<::std::pair<unsigned, size_t>>    call_stack;
+    unsigned next_index = 0;
+    auto push = [&](unsigned v) {
+        index[v] = lowlink[v] = next_index ++;
+        scc_stack.push_back(v);
+        on_stack[v] = true;
+        call_stack.push_back(::std::make_pair(v, size_t(0)));
+        };
+    for(unsigned root = 0; root < n_blocks; root ++)
+    {
+        if( index[root] != UNVISITED )
+            continue ;
+        push(root);
+        while( !call_stack.empty() )
+        {
+            auto v = call_stack.back().first;
+            auto& next_succ = call_stack.back().second;
+            if( next_succ < succs[v].size() )
+            {
+                auto w = succs[v][next_succ ++];
+                if( index[w] == UNVISITED ) {
+                    push(w);
+                }
+                else if( on_stack[w] ) {
+                    lowlink[v] = ::std::min(lowlink[v], index[w]);
+                }
+                continue ;
+            }
+
+            call_stack.pop_back();
+            if( !call_stack.empty() ) {
+                auto p = call_stack.back().first;
+                lowlink[p] = ::std::min(lowlink[p], lowlink[v]);
+            }
+            if( lowlink[v] == index[v] )
+            {
+                // `v` is the root of a SCC, pop it off the stack (it's a cycle if there's more than one block)
+                size_t start = scc_stack.size();
+                do {
+                    start --;
+                } while( scc_stack[start] != v );
+                bool is_cycle = scc_stack.size() - start > 1;
+                for(size_t i = start; i < scc_stack.size(); i ++)
+                {
+                    on_stack[scc_stack[i]] = false;
+                    if( is_cycle )
+                        rv[scc_stack[i]] = true;
+                }
+                scc_stack.resize(start);
+            }
+        }
+    }
+    return rv;
+}
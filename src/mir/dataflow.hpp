@@ -0,0 +1,66 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * mir/dataflow.hpp
+ * - Block-level dataflow analysis of MIR locals (using dense bitsets)
+ */
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace MIR {
+
+class TypeResolve;
+class Function;
+class Statement;
+class Terminator;
+
+/// Dense bitset with one bit per local
+class LocalBitSet
+{
+    ::std::vector<uint64_t> m_words;
+public:
+    LocalBitSet() {}
+    LocalBitSet(size_t count):
+        m_words( (count + 63) / 64 )
+    {}
+
+    bool test(size_t i) const { return (m_words[i / 64] >> (i % 64)) & 1; }
+    void set(size_t i) { m_words[i / 64] |= (1ull << (i % 64)); }
+    void reset(size_t i) { m_words[i / 64] &= ~(1ull << (i % 64)); }
+
+    /// Add all bits from `x`, returns true if a new bit was set
+    bool union_with(const LocalBitSet& x);
+    /// Remove all bits present in `x`
+    void subtract(const LocalBitSet& x);
+
+    bool operator==(const LocalBitSet& x) const { return m_words == x.m_words; }
+    bool operator!=(const LocalBitSet& x) const { return m_words != x.m_words; }
+};
+
+/// Liveness of locals at block boundaries
+///
+/// A local is live at a point if its current value may be read (or dropped) later on some path. Locals that are
+/// borrowed at any point are not tracked (as the borrow could be used to read them), and are always considered live.
+struct LocalLiveness
+{
+    /// Locals that have a borrow taken somewhere in the function
+    LocalBitSet borrowed;
+    /// Per-block set of locals live at the start of the block
+    ::std::vector<LocalBitSet>  live_in;
+    /// Per-block set of locals live after the terminator
+    ::std::vector<LocalBitSet>  live_out;
+
+    /// Update `live` (the set of locals live after `stmt`) to the set live before it
+    void step_back(const Statement& stmt, LocalBitSet& live) const;
+    /// Update `live` (the union of the successors' live-in sets) to the set live before `term`
+    void step_back(const Terminator& term, LocalBitSet& live) const;
+};
+
+}   // namespace MIR
+
+extern ::MIR::LocalLiveness MIR_Helper_GetLiveness(::MIR::TypeResolve& state, const ::MIR::Function& fcn);
+/// Determine which blocks are part of a cycle in the control flow graph (i.e. may execute more than once)
+extern ::std::vector<bool> MIR_Helper_GetCyclicBlocks(const ::MIR::Function& fcn);
@@ -13,6 +13,7 @@
 #include <hir/type.hpp>
 #include "../hir/asm.hpp"
 #include <int128.h>
+#include <small_vec.hpp>
 #include <cstdint>
 
 struct MonomorphState;
@@ -24,7 +25,7 @@ typedef unsigned int    BasicBlockId;
 
 // Store LValues as:
 // - A packed root value (one word, using the low bits as an enum descriminator)
-// - A list of (inner to outer) wrappers
+// - A list of (inner to outer) wrappers (stored inline for short chains)
 struct LValue
 {
     class Storage
@@ -155,14 +156,17 @@ struct LValue
         bool operator!=(const Wrapper& x) const { return val != x.val; }
     };
 
+    // Most lvalues have only a few wrappers, so store them inline to avoid allocating on every clone
+    typedef SmallVec<Wrapper, 4>    WrapperList;
+
     Storage m_root;
-    ::std::vector<Wrapper>  m_wrappers;
+    WrapperList m_wrappers;
 
     LValue()
         :m_root( Storage::new_Return() )
     {
     }
-    LValue(Storage root, ::std::vector<Wrapper> wrappers)
+    LValue(Storage root, WrapperList wrappers)
         :m_root( ::std::move(root) )
         ,m_wrappers( ::std::move(wrappers) )
     {
@@ -197,7 +201,7 @@ struct LValue
     LValue clone() const {
         return LValue(m_root.clone(), m_wrappers);
     }
-    LValue clone_wrapped(::std::vector<Wrapper> wrappers) const {
+    LValue clone_wrapped(WrapperList wrappers) const {
         if( this->m_wrappers.empty() ) {
             return LValue(m_root.clone(), ::std::move(wrappers));
         }
@@ -207,7 +211,7 @@ struct LValue
     }
     template<typename It>
     LValue clone_wrapped(It begin_it, It end_it) const {
-        ::std::vector<Wrapper>  wrappers;
+        WrapperList wrappers;
         wrappers.reserve(m_wrappers.size() + ::std::distance(begin_it, end_it));
         wrappers.insert(wrappers.end(), m_wrappers.begin(), m_wrappers.end());
         wrappers.insert(wrappers.end(), begin_it, end_it);
@@ -217,7 +221,7 @@ struct LValue
     LValue clone_unwrapped(unsigned count=1) const {
         assert(count > 0);
         assert(count <= m_wrappers.size());
-        return LValue(m_root.clone(), ::std::vector<Wrapper>(m_wrappers.begin(), m_wrappers.end() - count));
+        return LValue(m_root.clone(), WrapperList(m_wrappers.begin(), m_wrappers.end() - count));
     }
 
     // Returns true if this LValue is a subset of the other (e.g. `_1.0` is a subset of `_1.0*`)
@@ -251,7 +255,7 @@ struct LValue
 
     public:
         LValue clone() const {
-            return ::MIR::LValue( m_lv->m_root.clone(), ::std::vector<Wrapper>(m_lv->m_wrappers.begin(), m_lv->m_wrappers.begin() + m_wrapper_count) );
+            return ::MIR::LValue( m_lv->m_root.clone(), WrapperList(m_lv->m_wrappers.begin(), m_lv->m_wrappers.begin() + m_wrapper_count) );
         }
 
         const LValue& lv() const { return *m_lv; }
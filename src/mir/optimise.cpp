@@ -11,11 +11,13 @@
 #include <hir/visitor.hpp>
 #include <hir_typeck/static.hpp>
 #include <mir/helpers.hpp>
+#include <mir/dataflow.hpp>
 #include <mir/operations.hpp>
 #include <mir/visit_crate_mir.hpp>
 #include <algorithm>
 #include <cmath>
 #include <iomanip>
+#include <unordered_map>
 #include <trans/target.hpp>
 #include <trans/trans_list.hpp> // Note: This is included for inlining after enumeration and monomorph
 
@@ -37,6 +39,7 @@ bool MIR_Optimise_BlockSimplify(::MIR::TypeResolve& state, ::MIR::Function& fcn)
 bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool minimal, const TransList* list=nullptr);
 bool MIR_Optimise_SplitAggregates(::MIR::TypeResolve& state, ::MIR::Function& fcn);
 bool MIR_Optimise_PropagateSingleAssignments(::MIR::TypeResolve& state, ::MIR::Function& fcn);
+bool MIR_Optimise_CopyPropagate(::MIR::TypeResolve& state, ::MIR::Function& fcn);
 bool MIR_Optimise_PropagateKnownValues(::MIR::TypeResolve& state, ::MIR::Function& fcn);
 bool MIR_Optimise_DeTemporary(::MIR::TypeResolve& state, ::MIR::Function& fcn); // Eliminate useless temporaries
 bool MIR_Optimise_UnifyTemporaries(::MIR::TypeResolve& state, ::MIR::Function& fcn);
@@ -94,6 +97,25 @@ static bool check_after_all() {
     return check_mode() >= CHECKMODE_ALL;
 }
 
+/// Read a numeric tuning value from the environment (returning `def` if unset or invalid)
+static size_t tuning_value(const char* name, size_t def) {
+    const auto* n = getenv(name);
+    if( !n || !*n )
+        return def;
+    char* end;
+    auto v = strtoul(n, &end, 10);
+    if( *end != '\0' ) {
+        WARNING(Span(), W0000, "Invalid value for $" << name << " - '" << n << "', expected an integer");
+        return def;
+    }
+    return v;
+}
+/// Maximum number of statements in a function considered for inlining
+static size_t inline_stmt_limit() {
+    static size_t v = tuning_value("MRUSTC_INLINE_STMT_LIMIT", 10);
+    return v;
+}
+
 /// A minimum set of optimisations:
 /// - Inlines `#[inline(always)]` functions
 /// - Simplifies the call graph (by removing chained gotos)
@@ -265,6 +287,18 @@ void MIR_Optimise(const StaticTraitResolve& resolve, const ::HIR::ItemPath& path
         }
         //else { MIR_Validate(resolve, path, fcn, args, ret_type); }
 
+        // >> Forward copies of single-assignment values to all of their uses
+        if( MIR_Optimise_CopyPropagate(state, fcn) )
+        {
+#if DUMP_AFTER_ALL
+            if( debug_enabled() ) MIR_Dump_Fcn(::std::cout, fcn);
+#endif
+            if( check_after_all() ) {
+                MIR_Validate(resolve, path, fcn, args, ret_type);
+            }
+            change_happened = true;
+        }
+
         // >> Move common statements (assignments) across gotos.
         //if( MIR_Optimise_CommonStatements(state, fcn) )
         //{
@@ -1156,14 +1190,14 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
             // TODO: Allow functions that are just a switch on an input.
             if( fcn.blocks.size() == 1 )
             {
-                return fcn.blocks[0].statements.size() < 10 && ! fcn.blocks[0].terminator.is_Goto();
+                return fcn.blocks[0].statements.size() < inline_stmt_limit() && ! fcn.blocks[0].terminator.is_Goto();
             }
             else if( fcn.blocks.size() == 2 && fcn.blocks[0].terminator.is_Call() )
             {
                 const auto& blk0_te = fcn.blocks[0].terminator.as_Call();
                 if( !fcn.blocks[1].terminator.is_Diverge() )
                     return false;
-                if( fcn.blocks[0].statements.size() + fcn.blocks[1].statements.size() > 10 )
+                if( fcn.blocks[0].statements.size() + fcn.blocks[1].statements.size() > inline_stmt_limit() )
                     return false;
                 // Detect and avoid simple recursion.
                 // - This won't detect mutual recursion - that also needs prevention.
@@ -1179,7 +1213,7 @@ bool MIR_Optimise_Inlining(::MIR::TypeResolve& state, ::MIR::Function& fcn, bool
                     return false;
                 if( !(fcn.blocks[2].terminator.is_Diverge() || fcn.blocks[2].terminator.is_Return()) )
                     return false;
-                if( fcn.blocks[0].statements.size() + fcn.blocks[1].statements.size() + fcn.blocks[2].statements.size() > 10 )
+                if( fcn.blocks[0].statements.size() + fcn.blocks[1].statements.size() + fcn.blocks[2].statements.size() > inline_stmt_limit() )
                     return false;
                 // Detect and avoid simple recursion.
                 // - This won't detect mutual recursion - that also needs prevention.
@@ -4872,7 +4906,7 @@ bool MIR_Optimise_SplitAggregates(::MIR::TypeResolve& state, ::MIR::Function& fc
                     field_idx = lv.m_wrappers[1].as_Field();
                     ndel = 2;
                 }
-                auto new_wrappers = std::vector<MIR::LValue::Wrapper>(lv.m_wrappers.begin() + ndel, lv.m_wrappers.end());
+                auto new_wrappers = MIR::LValue::WrapperList(lv.m_wrappers.begin() + ndel, lv.m_wrappers.end());
                 auto new_root = MIR::LValue::Storage::new_Local(it->second.replacements.at(field_idx));
                 auto new_lv = MIR::LValue(mv$(new_root), mv$(new_wrappers));
                 DEBUG(state << " " << lv << " -> " << new_lv);
@@ -5417,6 +5451,157 @@ bool MIR_Optimise_PropagateSingleAssignments(::MIR::TypeResolve& state, ::MIR::F
     return replacement_happend;
 }
 
+// --------------------------------------------------------------------
+// Replace reads of `tmp` with `src` given `tmp = src` where both are only assigned once
+// --------------------------------------------------------------------
+// Locals that are assigned exactly once (and never borrowed or partially written) are treated as SSA values, as long
+// as their definition can only execute once (i.e. isn't in a loop). Copies of such values (or of unmodified arguments)
+// can then be forwarded to every use in a single linear pass, leaving the copy itself to `DeadAssignments`.
+bool MIR_Optimise_CopyPropagate(::MIR::TypeResolve& state, ::MIR::Function& fcn)
+{
+    bool changed = false;
+    TRACE_FUNCTION_FR("", changed);
+
+    struct LocalInfo {
+        unsigned n_defs = 0;
+        bool disqualified = false;
+        unsigned def_bb = 0;
+        unsigned def_stmt = 0;
+    };
+    ::std::vector<LocalInfo>    locals(fcn.locals.size());
+    ::std::vector<bool> args_modified(state.m_args.size());
+    {
+        unsigned cur_bb = 0, cur_stmt = 0;
+        auto cb = [&](const ::MIR::LValue& lv, ValUsage vu) {
+            // Accesses through a pointer don't change the root value
+            if( ::std::any_of(lv.m_wrappers.begin(), lv.m_wrappers.end(), [](const ::MIR::LValue::Wrapper& w){ return w.is_Deref(); }) )
+                return false;
+            if( !(vu == ValUsage::Write || vu == ValUsage::Borrow) )
+                return false;
+            if( lv.m_root.is_Local() )
+            {
+                auto& li = locals[lv.m_root.as_Local()];
+                if( vu == ValUsage::Write ) {
+                    li.n_defs += 1;
+                    li.def_bb = cur_bb;
+                    li.def_stmt = cur_stmt;
+                }
+                if( vu == ValUsage::Borrow || !lv.is_Local() ) {
+                    li.disqualified = true;
+                }
+            }
+            else if( lv.m_root.is_Argument() )
+            {
+                args_modified[lv.m_root.as_Argument()] = true;
+            }
+            return false;
+            };
+        for(const auto& bb : fcn.blocks)
+        {
+            cur_bb = &bb - &fcn.blocks.front();
+            for(const auto& stmt : bb.statements)
+            {
+                cur_stmt = &stmt - &bb.statements.front();
+                visit_mir_lvalues(stmt, cb);
+            }
+            cur_stmt = bb.statements.size();
+            visit_mir_lvalues(bb.terminator, cb);
+        }
+    }
+    auto is_ssa_local = [&](unsigned idx) {
+        return locals[idx].n_defs == 1 && !locals[idx].disqualified;
+        };
+
+    // - Locate `tmp = src` copies, where `src` cannot change after the copy
+    auto cyclic_blocks = MIR_Helper_GetCyclicBlocks(fcn);
+    ::std::map<unsigned, ::MIR::LValue>   replacements;
+    for(const auto& bb : fcn.blocks)
+    {
+        unsigned bb_idx = &bb - &fcn.blocks.front();
+        for(unsigned stmt_idx = 0; stmt_idx < bb.statements.size(); stmt_idx ++)
+        {
+            const auto& stmt = bb.statements[stmt_idx];
+            if( !stmt.is_Assign() || !stmt.as_Assign().dst.is_Local() || !stmt.as_Assign().src.is_Use() )
+                continue ;
+            auto dst_idx = stmt.as_Assign().dst.as_Local();
+            const auto& src = stmt.as_Assign().src.as_Use();
+            if( !is_ssa_local(dst_idx) || !src.m_wrappers.empty() )
+                continue ;
+            if( src.m_root.is_Argument() )
+            {
+                if( args_modified[src.m_root.as_Argument()] )
+                    continue ;
+            }
+            else if( src.m_root.is_Local() )
+            {
+                auto src_idx = src.m_root.as_Local();
+                if( src_idx == dst_idx || !is_ssa_local(src_idx) )
+                    continue ;
+                // If the source's definition can run again (loop), then it must be immediately followed by the copy
+                // - Otherwise a read of `tmp` between the two would see the previous iteration's value
+                const auto& li = locals[src_idx];
+                if( cyclic_blocks[li.def_bb] && !(li.def_bb == bb_idx && li.def_stmt + 1 == stmt_idx) )
+                    continue ;
+            }
+            else
+            {
+                continue ;
+            }
+            state.set_cur_stmt(bb_idx, stmt_idx);
+            if( !state.lvalue_is_copy(src) )
+                continue ;
+            DEBUG(state << "Forward " << stmt);
+            replacements.insert(::std::make_pair(dst_idx, src.clone()));
+        }
+    }
+    if( replacements.empty() )
+        return false;
+
+    // - Replace all reads (following chains of copies)
+    auto resolve = [&](unsigned idx)->const ::MIR::LValue* {
+        const ::MIR::LValue* rv = nullptr;
+        for(size_t limit = replacements.size(); limit --; )
+        {
+            auto it = replacements.find(idx);
+            if( it == replacements.end() )
+                break;
+            rv = &it->second;
+            if( !rv->is_Local() )
+                break;
+            idx = rv->as_Local();
+        }
+        return rv;
+        };
+    visit_mir_lvalues_mut(state, fcn, [&](::MIR::LValue& lv, ValUsage vu) {
+        // Leave the copies alone, they're removed later once unused
+        if( vu == ValUsage::Write && lv.is_Local() )
+            return false;
+        for(auto& w : lv.m_wrappers)
+        {
+            if( w.is_Index() )
+            {
+                const auto* r = resolve(w.as_Index());
+                if( r && r->is_Local() ) {
+                    w = ::MIR::LValue::Wrapper::new_Index(r->as_Local());
+                    changed = true;
+                }
+            }
+        }
+        if( lv.m_root.is_Local() )
+        {
+            if( const auto* r = resolve(lv.m_root.as_Local()) )
+            {
+                MIR_DEBUG(state, lv << " => " << *r);
+                lv.m_root = r->m_root.clone();
+                changed = true;
+            }
+        }
+        return false;
+        });
+
+    return changed;
+}
+
 // ----------------------------------------
 // Clear all drop flags that are never read
 // ----------------------------------------
@@ -5593,6 +5778,38 @@ bool MIR_Optimise_DeadAssignments(::MIR::TypeResolve& state, ::MIR::Function& fc
         }
     }
 
+    // Remove assignments to locals that are dead immediately afterwards (overwritten or not read on any path)
+    // - Borrowed locals are always live, so only need to ensure that no non-Copy value is moved by the assignment
+    auto liveness = MIR_Helper_GetLiveness(state, fcn);
+    for(size_t bb_idx = 0; bb_idx < fcn.blocks.size(); bb_idx ++)
+    {
+        auto& bb = fcn.blocks[bb_idx];
+        auto live = liveness.live_out[bb_idx];
+        liveness.step_back(bb.terminator, live);
+        for(size_t stmt_idx = bb.statements.size(); stmt_idx --; )
+        {
+            const auto& stmt = bb.statements[stmt_idx];
+            state.set_cur_stmt(bb_idx, stmt_idx);
+            if( stmt.is_Assign() && stmt.as_Assign().dst.is_Local() && !live.test(stmt.as_Assign().dst.as_Local()) )
+            {
+                bool moves_value = false;
+                visit_mir_lvalues(stmt.as_Assign().src, [&](const ::MIR::LValue& lv, ValUsage vu) {
+                    if( (vu == ValUsage::Move || vu == ValUsage::Read) && !state.lvalue_is_copy(lv) )
+                        moves_value = true;
+                    return moves_value;
+                    });
+                if( !moves_value )
+                {
+                    DEBUG(state << "Dead assignment, remove - " << stmt);
+                    bb.statements.erase(bb.statements.begin() + stmt_idx);
+                    changed = true;
+                    continue ;
+                }
+            }
+            liveness.step_back(stmt, live);
+        }
+    }
+
     // Locate assignments of locals then find the next assignment or read.
     return changed;
 }
@@ -6477,16 +6694,84 @@ void MIR_OptimiseCrate_Inlining(const ::HIR::Crate& crate, TransList& list)
 
     ::StaticTraitResolve    resolve { crate };
 
+    typedef decltype(list.m_functions)::value_type  fcn_ent_t;
+    // Order the functions so callees are visited before their callers (post-order walk of the call graph)
+    // - A callee has then already had its own calls inlined (and been re-optimised) when its callers consider
+    //   inlining it, so chains of small wrappers collapse in one pass instead of one level per iteration.
+    // - Within a cycle (recursion) the order is arbitrary
+    ::std::vector<fcn_ent_t*>   order;
+    {
+        ::std::vector<fcn_ent_t*>   ents;
+        ::std::unordered_map<const TransList_Function*, size_t>  ent_idx;
+        for(auto& fcn_ent : list.m_functions)
+        {
+            ent_idx.insert(::std::make_pair(fcn_ent.second.get(), ents.size()));
+            ents.push_back(&fcn_ent);
+        }
+        auto get_callees = [&](const fcn_ent_t& fcn_ent) {
+            ::std::vector<size_t>   rv;
+            const ::MIR::Function* mir = fcn_ent.second->monomorphised.code
+                ? &*fcn_ent.second->monomorphised.code
+                : fcn_ent.second->ptr->m_code.get_mir_opt();
+            if( mir )
+            {
+                for(const auto& bb : mir->blocks)
+                {
+                    if( const auto* te = bb.terminator.opt_Call() )
+                    {
+                        if( te->fcn.is_Path() )
+                        {
+                            auto it = list.m_functions.find(te->fcn.as_Path());
+                            if( it != list.m_functions.end() )
+                                rv.push_back(ent_idx.at(it->second.get()));
+                        }
+                    }
+                }
+            }
+            return rv;
+            };
+
+        ::std::vector<bool> visited(ents.size());
+        // Stack of (function, callees not yet visited)
+        ::std::vector<::std::pair<size_t, ::std::vector<size_t>>>   stack;
+        order.reserve(ents.size());
+        for(size_t root = 0; root < ents.size(); root ++)
+        {
+            if( visited[root] )
+                continue ;
+            visited[root] = true;
+            stack.push_back(::std::make_pair(root, get_callees(*ents[root])));
+            while( !stack.empty() )
+            {
+                auto& callees = stack.back().second;
+                if( !callees.empty() )
+                {
+                    auto c = callees.back();
+                    callees.pop_back();
+                    if( !visited[c] ) {
+                        visited[c] = true;
+                        stack.push_back(::std::make_pair(c, get_callees(*ents[c])));
+                    }
+                    continue ;
+                }
+                order.push_back(ents[stack.back().first]);
+                stack.pop_back();
+            }
+        }
+    }
+
     bool did_inline_on_pass;
 
-    size_t  MAX_ITERATIONS = 5; // TODO: Tune this.
+    // NOTE: With callees visited first, later passes only pick up inlining enabled by the post-inline optimisation
+    const size_t MAX_ITERATIONS = tuning_value("MRUSTC_INLINE_MAX_ITERATIONS", 5);
     size_t  num_iterations = 0;
     do
     {
         did_inline_on_pass = false;
 
-        for(auto& fcn_ent : list.m_functions)
+        for(auto* fcn_ent_p : order)
         {
+            auto& fcn_ent = *fcn_ent_p;
             const auto& path = fcn_ent.first;
             //const auto& pp = fcn_ent.second->pp;
             auto& hir_fcn = *const_cast<::HIR::Function*>(fcn_ent.second->ptr);
@@ -6515,6 +6800,7 @@ void MIR_OptimiseCrate_Inlining(const ::HIR::Crate& crate, TransList& list)
                 // Extern, no optimisations
             }
         }
+        num_iterations ++;
     } while( did_inline_on_pass && num_iterations < MAX_ITERATIONS );
 
     if( did_inline_on_pass )
@@ -7,35 +7,94 @@
  */
 #include <functional>
 #include <iostream>
+#include <deque>
+#include <unordered_map>
+#include <cassert>
 #include <span.hpp>
 #include <parse/lex.hpp>
 #include <common.hpp>
 
-SpanInner Span::s_empty_span;
+namespace {
+    /// Global table of all spans (append-only, `Span` is an index into this)
+    class SpanTable
+    {
+        struct Key {
+            uint32_t    parent;
+            uint32_t    file;
+            unsigned int start_line;
+            unsigned int start_ofs;
+            unsigned int end_line;
+            unsigned int end_ofs;
+
+            bool operator==(const Key& x) const {
+                return parent == x.parent && file == x.file
+                    && start_line == x.start_line && start_ofs == x.start_ofs
+                    && end_line == x.end_line && end_ofs == x.end_ofs;
+            }
+        };
+        struct KeyHash {
+            size_t operator()(const Key& k) const {
+                size_t rv = k.parent;
+                for(size_t v : { size_t(k.file), size_t(k.start_line), size_t(k.start_ofs), size_t(k.end_line), size_t(k.end_ofs) })
+                    rv = rv * 31 + v;
+                return rv;
+            }
+        };
+
+        // NOTE: A deque, so references to entries stay valid when the table grows
+        ::std::deque<SpanInner> m_entries;
+        ::std::unordered_map<Key, uint32_t, KeyHash>   m_lookup;
+        // File names (by content, so equal names from different strings share an ID)
+        ::std::unordered_map<RcString, uint32_t>    m_file_ids;
+
+    public:
+        SpanTable()
+        {
+            // Index zero is the empty span
+            m_entries.push_back(SpanInner());
+        }
+
+        const SpanInner& get(uint32_t idx) const {
+            return m_entries[idx];
+        }
+        uint32_t intern(Span parent, uint32_t parent_idx, RcString filename, unsigned int start_line, unsigned int start_ofs, unsigned int end_line, unsigned int end_ofs)
+        {
+            auto file_it = m_file_ids.insert(::std::make_pair(filename, static_cast<uint32_t>(m_file_ids.size())));
+            Key k { parent_idx, file_it.first->second, start_line, start_ofs, end_line, end_ofs };
+            auto it = m_lookup.find(k);
+            if( it != m_lookup.end() )
+                return it->second;
+
+            auto idx = static_cast<uint32_t>(m_entries.size());
+            assert(idx != 0 && "Span table overflow");
+            m_entries.push_back(SpanInner());
+            auto& e = m_entries.back();
+            e.parent_span = parent;
+            e.filename = ::std::move(filename);
+            e.start_line = start_line;
+            e.start_ofs = start_ofs;
+            e.end_line = end_line;
+            e.end_ofs = end_ofs;
+            m_lookup.insert(::std::make_pair(k, idx));
+            return idx;
+        }
+    };
+    SpanTable& span_table() {
+        static SpanTable    s_table;
+        return s_table;
+    }
+}
 
 Span::Span(Span parent, RcString filename, unsigned int start_line, unsigned int start_ofs,  unsigned int end_line, unsigned int end_ofs):
-    m_ptr(SpanInner::alloc( parent, ::std::move(filename), start_line, start_ofs, end_line, end_ofs ))
+    m_idx(span_table().intern( parent, parent.m_idx, ::std::move(filename), start_line, start_ofs, end_line, end_ofs ))
 {}
 Span::Span(Span parent, const Position& pos):
-    m_ptr(SpanInner::alloc( parent, pos.filename, pos.line,pos.ofs, pos.line,pos.ofs ))
-{
-}
-Span::Span(const Span& x):
-    m_ptr(x.m_ptr)
+    Span(parent, pos.filename, pos.line,pos.ofs, pos.line,pos.ofs)
 {
-    m_ptr->reference_count += 1;
 }
-Span::~Span()
+const SpanInner& Span::operator*() const
 {
-    if(m_ptr && m_ptr != &s_empty_span)
-    {
-        m_ptr->reference_count --;
-        if( m_ptr->reference_count == 0 )
-        {
-            delete m_ptr;
-        }
-        m_ptr = nullptr;
-    }
+    return span_table().get(m_idx);
 }
 
 namespace {
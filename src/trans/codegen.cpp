@@ -16,7 +16,7 @@
 #include "codegen.hpp"
 #include "monomorphise.hpp"
 
-void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const TransOptions& opt, const ::HIR::Crate& crate, const TransList& list, const ::std::string& hir_file)
+void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const TransOptions& opt, const ::HIR::Crate& crate, TransList& list, const ::std::string& hir_file)
 {
     static Span sp;
 
@@ -66,6 +66,7 @@ void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const Tra
             codegen->emit_type(ty.first);
         }
     }
+    codegen->emit_types_end();
     for(const auto& ty : list.m_typeids)
     {
         codegen->emit_type_id(ty);
@@ -190,6 +191,9 @@ void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const Tra
                 // TODO: Flag that this should be a weak (or weak-er) symbol?
                 // - If it's from an external crate, it should be weak, but what about local ones?
                 codegen->emit_function_code(path, fcn, ent.second->pp, is_extern,  ent.second->monomorphised.code);
+                // The code has been emitted, so release the monomorphised MIR
+                // - Bounds memory usage during codegen to the un-emitted functions, instead of every monomorphised copy
+                ent.second->monomorphised.code.reset();
             }
             else {
                 codegen->emit_function_code(path, fcn, pp, is_extern,  fcn.m_code.m_mir);
@@ -34,6 +34,8 @@ public:
     virtual void emit_type_proto(const ::HIR::TypeRef& ) {}
     virtual void emit_type(const ::HIR::TypeRef& ) {}
     virtual void emit_type_id(const ::HIR::TypeRef& ) {}
+    // Called once all type prototypes and definitions have been emitted
+    virtual void emit_types_end() {}
 
     // Called when a TypeRef::Path is encountered (after visiting inner types)
     virtual void emit_struct(const Span& sp, const ::HIR::GenericPath& p, const ::HIR::Struct& item) {}
@@ -19,6 +19,7 @@
 #include "target.hpp"
 #include "allocator.hpp"
 #include <iomanip>
+#include <cstdio>  // rename/remove
 
 namespace {
     struct FmtShell
@@ -179,6 +180,7 @@ namespace {
         };
 
         static Span sp;
+        static const size_t OUTPUT_BUFFER_SIZE = 1 << 20;
 
         const ::HIR::Crate& m_crate;
         ::StaticTraitResolve    m_resolve;
@@ -186,9 +188,19 @@ namespace {
         ::std::string   m_outfile_path;
         ::std::string   m_outfile_path_c;
 
+        /// Output buffer for `m_of` (larger than the default, as output is written in many small pieces)
+        ::std::unique_ptr<char[]>   m_of_buffer;
         ::std::ofstream m_of;
         const ::MIR::TypeResolve* m_mir_res;
 
+        /// Directory for the shared prelude header (from `MRUSTC_C_PRELUDE_DIR`), empty if the prelude is emitted inline
+        ::std::string   m_prelude_dir;
+        /// Content of the shared prelude, written out by `finalise`
+        ::std::string   m_prelude;
+        /// Range of `m_of` holding the type definitions (copied to this crate's shared types header by `finalise`)
+        ::std::streampos    m_types_start;
+        ::std::streampos    m_types_end;
+
         Compiler    m_compiler = Compiler::Gcc;
         struct {
             bool emulated_i128 = false;
@@ -204,8 +216,11 @@ namespace {
             m_resolve(crate),
             m_outfile_path(outfile),
             m_outfile_path_c(outfile + ".c"),
-            m_of(m_outfile_path_c)
+            m_of_buffer(new char[OUTPUT_BUFFER_SIZE])
         {
+            // NOTE: The buffer has to be set before the file is opened
+            m_of.rdbuf()->pubsetbuf(m_of_buffer.get(), OUTPUT_BUFFER_SIZE);
+            m_of.open(m_outfile_path_c);
             ASSERT_BUG(Span(), m_of.is_open(), "Failed to open `" << m_outfile_path_c << "` for writing");
             m_options.emulated_i128 = Target_GetCurSpec().m_backend_c.m_emulated_i128;
             switch(Target_GetCurSpec().m_backend_c.m_codegen_mode)
@@ -228,7 +243,9 @@ namespace {
                 break;
             }
 
-            m_of
+            // Common definitions and helpers (independent of the crate being compiled)
+            ::std::ostringstream    prelude;
+            prelude
                 << "/*\n"
                 << " * AUTOGENERATED by mrustc\n"
                 << " */\n"
@@ -241,7 +258,7 @@ namespace {
             switch(m_compiler)
             {
             case Compiler::Gcc:
-                m_of
+                prelude
                     << "#include <stdatomic.h>\n"   // atomic_*
                     << "#include <stdlib.h>\n"  // abort
                     << "#include <string.h>\n"  // mem*
@@ -250,14 +267,14 @@ namespace {
                     ;
                 break;
             case Compiler::Msvc:
-                m_of
+                prelude
                     << "#include <windows.h>\n"
                     << "#include <math.h>\n"  // fabsf, ...
                     << "void abort(void);\n"
                     ;
                 break;
             }
-            m_of
+            prelude
                 << "typedef uint32_t RUST_CHAR;\n"
                 << "typedef uint8_t RUST_BOOL;\n"
                 << "typedef struct { void* PTR; size_t META; } SLICE_PTR;\n"
@@ -266,7 +283,7 @@ namespace {
                 ;
             if( m_options.disallow_empty_structs )
             {
-                m_of
+                prelude
                     << "typedef struct { char _d; } tUNIT;\n"
                     << "typedef char tBANG;\n"
                     << "typedef struct { char _d; } tTYPEID;\n"
@@ -274,26 +291,26 @@ namespace {
             }
             else
             {
-                m_of
+                prelude
                     << "typedef struct { } tUNIT;\n"
                     << "typedef struct { } tBANG;\n"
                     << "typedef struct { } tTYPEID;\n"
                     ;
             }
-            m_of
+            prelude
                 << "static inline size_t ALIGN_TO(size_t s, size_t a) { return (s + a-1) / a * a; }\n"
                 << "\n"
                 ;
             switch(m_compiler)
             {
             case Compiler::Gcc:
-                m_of
+                prelude
                     << "extern void _Unwind_Resume(void) __attribute__((noreturn));\n"
                     << "#define ALIGNOF(t) __alignof__(t)\n"
                     ;
                 break;
             case Compiler::Msvc:
-                m_of
+                prelude
                     << "__declspec(noreturn) static void _Unwind_Resume(void) { abort(); }\n"
                     << "#define ALIGNOF(t) __alignof(t)\n"
                     ;
@@ -304,12 +321,12 @@ namespace {
             switch (m_compiler)
             {
             case Compiler::Gcc:
-                m_of
+                prelude
                     << "extern __thread jmp_buf*    mrustc_panic_target;\n"
                     << "extern __thread void* mrustc_panic_value;\n"
                     ;
                 // 64-bit bit ops (gcc intrinsics)
-                m_of
+                prelude
                     << "static inline uint64_t __builtin_clz64(uint64_t v) {\n"
                     << "\treturn ( (v >> 32) != 0 ? __builtin_clz(v>>32) : 32 + __builtin_clz(v));\n"
                     << "}\n"
@@ -320,7 +337,7 @@ namespace {
                 // Atomic hackery
                 for(int sz = 8; sz <= 64; sz *= 2)
                 {
-                    m_of
+                    prelude
                         << "static inline uint"<<sz<<"_t __mrustc_atomicloop"<<sz<<"(volatile uint"<<sz<<"_t* slot, uint"<<sz<<"_t param, int ordering, uint"<<sz<<"_t (*cb)(uint"<<sz<<"_t, uint"<<sz<<"_t)) {"
                         << " int ordering_load = (ordering == memory_order_release || ordering == memory_order_acq_rel ? memory_order_relaxed : ordering);" // If Release, Load with Relaxed
                         << " for(;;) {"
@@ -332,7 +349,7 @@ namespace {
                 }
                 break;
             case Compiler::Msvc:
-                m_of
+                prelude
                     << "static inline int32_t __builtin_popcountll(uint64_t v) {\n"
                     << "\treturn __popcnt(v & 0xFFFFFFFF) + __popcnt(v >> 32);\n"
                     << "}\n"
@@ -540,7 +557,7 @@ namespace {
                 // Atomic hackery
                 for(int sz = 8; sz <= 64; sz *= 2)
                 {
-                    m_of
+                    prelude
                         << "static inline uint"<<sz<<"_t __mrustc_atomicloop"<<sz<<"(volatile uint"<<sz<<"_t* slot, uint"<<sz<<"_t param, uint"<<sz<<"_t (*cb)(uint"<<sz<<"_t, uint"<<sz<<"_t)) {"
                         << " for(;;) {"
                         << " uint"<<sz<<"_t v = InterlockedCompareExchange" << sz << "(slot, 0,0);"
@@ -554,7 +571,7 @@ namespace {
 
             if( m_options.emulated_i128 )
             {
-                m_of
+                prelude
                     << "typedef struct { uint64_t lo, hi; } uint128_t;\n"
                     << "typedef struct { uint64_t lo, hi; } int128_t;\n"
                     << "static inline uint128_t intrinsic_ctlz_u128(uint128_t v);\n"
@@ -703,7 +720,7 @@ namespace {
             else
             {
                 // GCC-only
-                m_of
+                prelude
                     << "typedef unsigned __int128 uint128_t;\n"
                     << "typedef signed __int128 int128_t;\n"
                     << "static inline uint128_t __builtin_bswap128(uint128_t v) {\n"
@@ -721,7 +738,7 @@ namespace {
             }
 
             // Common helpers
-            m_of
+            prelude
                 << "\n"
                 << "static inline int slice_cmp(SLICE_PTR l, SLICE_PTR r) {\n"
                 << "\tint rv = memcmp(l.PTR, r.PTR, l.META < r.META ? l.META : r.META);\n"
@@ -755,11 +772,11 @@ namespace {
                 ;
             if( m_options.emulated_i128 )
             {
-                m_of << "static inline uint128_t __mrustc_bitrev128(uint128_t v) { uint128_t rv = { __mrustc_bitrev64(v.hi), __mrustc_bitrev64(v.lo) }; return rv; }\n";
+                prelude << "static inline uint128_t __mrustc_bitrev128(uint128_t v) { uint128_t rv = { __mrustc_bitrev64(v.hi), __mrustc_bitrev64(v.lo) }; return rv; }\n";
             }
             else
             {
-                m_of << "static inline uint128_t __mrustc_bitrev128(uint128_t v) {"
+                prelude << "static inline uint128_t __mrustc_bitrev128(uint128_t v) {"
                     << " if(v==0) return 0;"
                     << " uint128_t rv = ((uint128_t)__mrustc_bitrev64(v>>64))|((uint128_t)__mrustc_bitrev64(v)<<64);"
                     << " return rv;"
@@ -768,7 +785,7 @@ namespace {
             }
             for(int sz = 8; sz <= 64; sz *= 2)
             {
-                m_of
+                prelude
                     << "static inline uint"<<sz<<"_t __mrustc_op_umax"<<sz<<"(uint"<<sz<<"_t a, uint"<<sz<<"_t b) { return (a > b ? a : b); }\n"
                     << "static inline uint"<<sz<<"_t __mrustc_op_umin"<<sz<<"(uint"<<sz<<"_t a, uint"<<sz<<"_t b) { return (a < b ? a : b); }\n"
                     << "static inline uint"<<sz<<"_t __mrustc_op_imax"<<sz<<"(uint"<<sz<<"_t a, uint"<<sz<<"_t b) { return ((int"<<sz<<"_t)a > (int"<<sz<<"_t)b ? a : b); }\n"
@@ -776,6 +793,25 @@ namespace {
                     << "static inline uint"<<sz<<"_t __mrustc_op_and_not"<<sz<<"(uint"<<sz<<"_t a, uint"<<sz<<"_t b) { return ~(a & b); }\n"
                     ;
             }
+
+            // If requested, the prelude is written to a shared header (see `emit_shared_prelude`) instead of into every file
+            const char* prelude_dir = getenv("MRUSTC_C_PRELUDE_DIR");
+            if( m_compiler == Compiler::Gcc && prelude_dir && *prelude_dir != '\0' )
+            {
+                m_prelude_dir = prelude_dir;
+                m_prelude = prelude.str();
+                m_of
+                    << "/*\n"
+                    << " * AUTOGENERATED by mrustc\n"
+                    << " * - Common definitions (and upstream types) are in a shared prelude header (passed with `-include`)\n"
+                    << " */\n"
+                    ;
+                m_types_start = m_of.tellp();
+            }
+            else
+            {
+                m_of << prelude.str();
+            }
         }
 
         ~CodeGenerator_C() {}
@@ -1178,6 +1214,20 @@ namespace {
             switch( m_compiler )
             {
             case Compiler::Gcc:
+                // Optional launcher for the compiler (e.g. `ccache`, or the client of a persistent compile server like `sccache`)
+                // - from `MRUSTC_CC_LAUNCHER_${TRIPLE}` or `MRUSTC_CC_LAUNCHER` (same rules as `CC` below)
+                {
+                    std::string varname = "MRUSTC_CC_LAUNCHER_" +  Target_GetCurSpec().m_backend_c.m_c_compiler;
+                    std::replace(varname.begin(), varname.end(), '-', '_');
+
+                    const char* launcher = getenv(varname.c_str());
+                    if( !launcher ) {
+                        launcher = getenv("MRUSTC_CC_LAUNCHER");
+                    }
+                    if( launcher && *launcher != '\0' ) {
+                        args.push_back( launcher );
+                    }
+                }
                 // Pick the compiler
                 // - from `CC_${TRIPLE}` environment variable, with all '-' in TRIPLE replaced by '_'
                 // - from the `CC` environment variable
@@ -1220,6 +1270,12 @@ namespace {
                     args.push_back("-g");
                 }
                 args.push_back("-fPIC");
+                if( !m_prelude_dir.empty() )
+                {
+                    auto prelude_path = emit_shared_prelude(opt, args, is_windows);
+                    args.push_back("-include");
+                    args.push_back(::std::move(prelude_path));
+                }
                 args.push_back("-o");
                 switch(out_ty)
                 {
@@ -1444,6 +1500,115 @@ namespace {
             }
         }
 
+        /// Write the shared prelude header (and a GCC precompiled header for it), returning the header's path
+        ///
+        /// The header holds the prelude, followed by the type definitions of each upstream crate (saved by that crate's
+        /// own build, see `m_types_start`). The file name includes a hash of the content and of the compiler arguments
+        /// (the PCH is only usable with matching options), so crates with the same dependencies and options share one
+        /// header and PCH.
+        ::std::string emit_shared_prelude(const TransOptions& opt, const StringList& args, bool is_windows)
+        {
+            // FNV-1a (stable across runs, unlike `std::hash`)
+            auto hash_content = [&](const ::std::string& content)->::std::string {
+                uint64_t hash = 0xcbf29ce484222325ull;
+                auto update = [&](const char* s) {
+                    do {
+                        hash ^= static_cast<uint8_t>(*s);
+                        hash *= 0x100000001b3ull;
+                    } while( *s++ );
+                    };
+                update(content.c_str());
+                for(const auto* a : args)
+                    update(a);
+                return FMT(::std::hex << ::std::setw(16) << ::std::setfill('0') << hash);
+                };
+            // Temporary files are suffixed with this crate's output name, as other compiler instances could be writing the same file
+            auto tmp_suffix = "." + m_outfile_path.substr(m_outfile_path.find_last_of("/\\") + 1) + ".tmp";
+            auto write_file = [&](const ::std::string& path, const ::std::string& content) {
+                auto tmp_path = path + tmp_suffix;
+                {
+                    ::std::ofstream ofs(tmp_path);
+                    ofs << content;
+                    ASSERT_BUG(Span(), ofs.good(), "Failed to write `" << tmp_path << "`");
+                }
+                return ::std::rename(tmp_path.c_str(), path.c_str()) == 0;
+                };
+
+            // Save this crate's type definitions for downstream crates, keyed on the prelude (the definitions depend on it)
+            // - Always replaced, as the crate may have changed since the last build
+            auto types_prefix = FMT(m_prelude_dir << "/mrustc-types-" << hash_content(m_prelude) << "-");
+            if( m_types_end > m_types_start )
+            {
+                ::std::ifstream ifs(m_outfile_path_c, ::std::ios::binary);
+                ::std::string   types(static_cast<size_t>(m_types_end - m_types_start), '\0');
+                ifs.seekg(m_types_start);
+                ifs.read(&types[0], types.size());
+                ASSERT_BUG(Span(), ifs.good(), "Failed to read type definitions back from `" << m_outfile_path_c << "`");
+
+                auto path = types_prefix + m_crate.m_crate_name.c_str() + ".h";
+                if( !write_file(path, types) )
+                {
+                    ::std::remove(path.c_str());
+                    if( !write_file(path, types) )
+                    {
+                        ::std::remove((path + tmp_suffix).c_str());
+                    }
+                }
+            }
+
+            // Upstream definitions go after the prelude in load order (so dependencies come first), duplicates are skipped by
+            // their guards (see `emit_def_guard_open`)
+            ::std::string   content = m_prelude;
+            for(const auto& ext : m_crate.m_ext_crates_ordered)
+            {
+                ::std::ifstream ifs(types_prefix + ext.c_str() + ".h", ::std::ios::binary);
+                if( ifs.good() )
+                {
+                    content += FMT("// Types from `" << ext << "`\n");
+                    content.append(::std::istreambuf_iterator<char>(ifs), ::std::istreambuf_iterator<char>());
+                }
+            }
+            ::std::string path = m_prelude_dir + "/mrustc-prelude-" + hash_content(content) + ".h";
+
+            if( !::std::ifstream(path).good() )
+            {
+                if( !write_file(path, content) )
+                {
+                    // Another instance won the race (and the content is identical)
+                    ::std::remove((path + tmp_suffix).c_str());
+                }
+            }
+
+            // Build the precompiled header, GCC/Clang will use `<path>.gch` automatically when `<path>` is included
+            // - Not done when just emitting the build command
+            auto pch_path = path + ".gch";
+            if( opt.build_command_file == "" && !::std::ifstream(pch_path).good() )
+            {
+                auto tmp_path = pch_path + tmp_suffix;
+                ::std::stringstream cmd_ss;
+                for(const auto* a : args)
+                {
+                    cmd_ss << "\"" << FmtShell(a, is_windows) << "\" ";
+                }
+                cmd_ss << "-x c-header \"" << FmtShell(path, is_windows) << "\" -o \"" << FmtShell(tmp_path, is_windows) << "\"";
+                ::std::cout << "Running command - " << cmd_ss.str() << ::std::endl;
+                if( system(cmd_ss.str().c_str()) == 0 )
+                {
+                    if( ::std::rename(tmp_path.c_str(), pch_path.c_str()) != 0 )
+                    {
+                        ::std::remove(tmp_path.c_str());
+                    }
+                }
+                else
+                {
+                    // Not fatal, the header will just be parsed normally
+                    WARNING(Span(), W0000, "Failed to build precompiled header for `" << path << "`");
+                    ::std::remove(tmp_path.c_str());
+                }
+            }
+            return path;
+        }
+
         void emit_box_drop(unsigned indent_level, const ::HIR::TypeRef& inner_type, const ::HIR::TypeRef& box_type, const ::MIR::LValue& slot, bool run_destructor)
         {
             auto indent = RepeatLitStr { "\t", static_cast<int>(indent_level) };
@@ -1502,6 +1667,31 @@ namespace {
             m_of << "\n";
         }
 
+        void emit_types_end() override
+        {
+            if( !m_prelude_dir.empty() )
+            {
+                m_types_end = m_of.tellp();
+            }
+        }
+
+        // When sharing types through the prelude header, each definition is guarded by a macro named after its mangled
+        // name, so definitions already provided by the header are skipped.
+        void emit_def_guard_open(const ::std::string& name)
+        {
+            if( !m_prelude_dir.empty() )
+            {
+                m_of << "#ifndef TYDEF_" << name << "\n#define TYDEF_" << name << "\n";
+            }
+        }
+        void emit_def_guard_close()
+        {
+            if( !m_prelude_dir.empty() )
+            {
+                m_of << "#endif\n";
+            }
+        }
+
         void emit_type_id(const ::HIR::TypeRef& ty) override
         {
             switch(m_compiler)
@@ -1527,7 +1717,7 @@ namespace {
                 }
                 }
             TU_ARMA(Function, te) {
-                emit_type_fn(ty); m_of << "\n";
+                emit_type_fn(ty);
                 }
             TU_ARMA(Array, te) {
                 m_of << "typedef struct "; emit_ctype(ty); m_of << " "; emit_ctype(ty); m_of << ";\n";
@@ -1564,6 +1754,7 @@ namespace {
             m_emitted_fn_types.insert(ty.clone());
 
             const auto& te = ty.data().as_Function();
+            emit_def_guard_open(FMT(Trans_Mangle(ty)));
             m_of << "typedef ";
             // TODO: ABI marker, need an ABI enum?
             if( te.m_rettype == ::HIR::TypeRef::new_unit() )
@@ -1600,7 +1791,8 @@ namespace {
                 }
                 m_of << " )";
             }
-            m_of << ";";
+            m_of << ";\n";
+            emit_def_guard_close();
         }
 
         // Shared logic between `emit_struct` and `emit_type` (w/ Tuple)
@@ -1790,6 +1982,7 @@ namespace {
             TU_ARMA(Tuple, te) {
                 if( te.size() > 0 )
                 {
+                    emit_def_guard_open(FMT(Trans_Mangle(ty)));
                     m_of << " // " << ty << "\n";
                     const auto* repr = Target_GetTypeRepr(sp, m_resolve, ty);
 
@@ -1799,13 +1992,15 @@ namespace {
                     {
                         m_of << "typedef char sizeof_assert_"; emit_ctype(ty); m_of << "[ (sizeof("; emit_ctype(ty); m_of << ") == " << repr->size << ") ? 1 : -1 ];\n";
                     }
+                    emit_def_guard_close();
                 }
                 }
             TU_ARMA(Function, te) {
+                m_of << "// " << ty << "\n";
                 emit_type_fn(ty);
-                m_of << " // " << ty << "\n";
                 }
             TU_ARMA(Array, te) {
+                emit_def_guard_open(FMT(Trans_Mangle(ty)));
                 m_of << "typedef ";
                 size_t align;
                 if( te.size.as_Known() == 0 ) {
@@ -1843,6 +2038,7 @@ namespace {
                 }
                 emit_ctype(ty); m_of << ";";
                 m_of << " // " << ty << "\n";
+                emit_def_guard_close();
                 }
             TU_ARMA(ErasedType, te) {
                 // TODO: Is this actually a bug?
@@ -1865,6 +2061,7 @@ namespace {
             const auto* repr = Target_GetTypeRepr(sp, m_resolve, item_ty);
             MIR_ASSERT(*m_mir_res, repr, "No repr for struct " << p);
 
+            emit_def_guard_open(FMT("s_" << Trans_Mangle(p)));
             m_of << "// struct " << p << "\n";
 
             emit_struct_inner(item_ty, repr, item.m_max_field_alignment);
@@ -1875,6 +2072,7 @@ namespace {
                 m_of << "typedef char sizeof_assert_" << Trans_Mangle(p) << "[ (sizeof(struct s_" << Trans_Mangle(p) << ") == " << repr->size << ") ? 1 : -1 ];\n";
             }
             m_of << "typedef char alignof_assert_" << Trans_Mangle(p) << "[ (ALIGNOF(struct s_" << Trans_Mangle(p) << ") == " << repr->align << ") ? 1 : -1 ];\n";
+            emit_def_guard_close();
 
             m_mir_res = nullptr;
         }
@@ -1889,6 +2087,7 @@ namespace {
             const auto* repr = Target_GetTypeRepr(sp, m_resolve, item_ty);
             MIR_ASSERT(*m_mir_res, repr != nullptr, "No repr for union " << item_ty);
 
+            emit_def_guard_open(FMT("u_" << Trans_Mangle(p)));
             m_of << "union u_" << Trans_Mangle(p) << " {\n";
             for(unsigned int i = 0; i < repr->fields.size(); i ++)
             {
@@ -1900,6 +2099,7 @@ namespace {
             {
                 m_of << "typedef char sizeof_assert_" << Trans_Mangle(p) << "[ (sizeof(union u_" << Trans_Mangle(p) << ") == " << repr->size << ") ? 1 : -1 ];\n";
             }
+            emit_def_guard_close();
 
             m_mir_res = nullptr;
         }
@@ -1990,6 +2190,7 @@ namespace {
                 union_fields.insert( union_fields.begin(), 0 );
             }
 
+            emit_def_guard_open(FMT("e_" << Trans_Mangle(p)));
             m_of << "// enum " << p << "\n";
             m_of << "struct e_" << Trans_Mangle(p) << " {\n";
 
@@ -2099,6 +2300,7 @@ namespace {
 
             size_t exp_size = (repr->size > 0 ? repr->size : (m_options.disallow_empty_structs ? 1 : 0));
             m_of << "typedef char sizeof_assert_" << Trans_Mangle(p) << "[ (sizeof(struct e_" << Trans_Mangle(p) << ") == " << exp_size << ") ? 1 : -1 ];\n";
+            emit_def_guard_close();
 
             m_mir_res = nullptr;
         }
@@ -2968,7 +3170,10 @@ namespace {
                 m_of << "#endif\n";
             }
             m_of << "}\n";
-            m_of.flush();
+            // Only flush when debugging (so the output is complete if the next function crashes), otherwise let the buffer fill
+            if( debug_enabled() ) {
+                m_of.flush();
+            }
             m_mir_res = nullptr;
         }
 
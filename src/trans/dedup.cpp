@@ -0,0 +1,386 @@
+/*
+ * MRustC - Rust Compiler
+ * - By John Hodge (Mutabah/thePowersGang)
+ *
+ * trans/dedup.cpp
+ * - Merging of functions with identical (post-inlining) code
+ *
+ * Many monomorphised instances end up with the same MIR (e.g. when a type parameter only affects constants that have
+ * been evaluated, or only appears behind a pointer that has been cast away). References to such duplicates are
+ * redirected to a single instance, and the now-unused copies are removed by `Trans_Enumerate_Cleanup`.
+ */
+#include "main_bindings.hpp"
+#include "trans_list.hpp"
+#include <hir/hir.hpp>
+#include <mir/mir.hpp>
+#include <mir/helpers.hpp>
+#include <unordered_map>
+
+namespace {
+    struct FcnInfo
+    {
+        const ::HIR::Path*  path;
+        const ::HIR::Function*  hir;
+        const ::HIR::TypeRef*   ret_ty;
+        const ::HIR::Function::args_t*  args;
+        ::MIR::Function*    mir;
+
+        /// Structural hash of the signature and MIR, zero if it needs to be recalculated
+        size_t  hash;
+        /// Only functions with internal linkage can be replaced
+        bool    is_candidate;
+        bool    is_replaced;
+    };
+
+    /// Hashes the structure of MIR (tags, locals, block indexes, constants, and paths)
+    /// - Types are hashed shallowly (tag, and the path of named types), collisions are handled by `is_equal`
+    struct Hasher: public ::MIR::visit::Visitor
+    {
+        size_t  h = 0;
+
+        void add(size_t v) {
+            // Boost's `hash_combine`
+            h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2);
+        }
+        void add(const RcString& s) {
+            add(::std::hash<RcString>()(s));
+        }
+        void add(const ::HIR::SimplePath& p) {
+            add(p.m_crate_name);
+            for(const auto& c : p.m_components)
+                add(c);
+        }
+
+        void visit_type(const ::HIR::TypeRef& t) override {
+            add(t.data().tag());
+            TU_MATCH_HDRA( (t.data()), {)
+            default:
+                break;
+            TU_ARMA(Primitive, te) {
+                add(static_cast<size_t>(te));
+                }
+            TU_ARMA(Path, te) {
+                visit_path(te.path);
+                }
+            TU_ARMA(Array, te) {
+                visit_type(te.inner);
+                }
+            TU_ARMA(Slice, te) {
+                visit_type(te.inner);
+                }
+            TU_ARMA(Borrow, te) {
+                add(static_cast<size_t>(te.type));
+                visit_type(te.inner);
+                }
+            TU_ARMA(Pointer, te) {
+                add(static_cast<size_t>(te.type));
+                visit_type(te.inner);
+                }
+            TU_ARMA(Tuple, te) {
+                add(te.size());
+                for(const auto& ity : te)
+                    visit_type(ity);
+                }
+            }
+        }
+        void visit_path(const ::HIR::Path& p) override {
+            add(p.m_data.tag());
+            TU_MATCH_HDRA( (p.m_data), {)
+            TU_ARMA(Generic, e) {
+                add(e.m_path);
+                }
+            TU_ARMA(UfcsInherent, e) {
+                add(e.item);
+                }
+            TU_ARMA(UfcsKnown, e) {
+                add(e.trait.m_path);
+                add(e.item);
+                }
+            TU_ARMA(UfcsUnknown, e) {
+                add(e.item);
+                }
+            }
+            ::MIR::visit::Visitor::visit_path(p);
+        }
+        void visit_genericpath(const ::HIR::GenericPath& p) override {
+            add(p.m_path);
+            ::MIR::visit::Visitor::visit_genericpath(p);
+        }
+        void visit_path_params(const ::HIR::PathParams& p) override {
+            add(p.m_types.size());
+            ::MIR::visit::Visitor::visit_path_params(p);
+        }
+
+        bool visit_lvalue(const ::MIR::LValue& lv, ::MIR::visit::ValUsage u) override {
+            if( lv.m_root.is_Static() ) {
+                add(lv.m_root.tag());
+                visit_path(lv.m_root.as_Static());
+            }
+            else {
+                add(lv.m_root.get_inner());
+            }
+            for(const auto& w : lv.m_wrappers)
+            {
+                add(w.tag());
+                add(w.get_inner());
+            }
+            return false;
+        }
+        bool visit_const(const ::MIR::Constant& c) override {
+            add(c.tag());
+            TU_MATCH_HDRA( (c), {)
+            default:
+                break;
+            TU_ARMA(Int, e) {
+                add(e.v.truncate_i64());
+                add(static_cast<size_t>(e.t));
+                }
+            TU_ARMA(Uint, e) {
+                add(e.v.truncate_u64());
+                add(static_cast<size_t>(e.t));
+                }
+            TU_ARMA(Float, e) {
+                add(::std::hash<double>()(e.v));
+                add(static_cast<size_t>(e.t));
+                }
+            TU_ARMA(Bool, e) {
+                add(e.v);
+                }
+            TU_ARMA(Bytes, e) {
+                add(::std::hash<::std::string>()(::std::string(e.begin(), e.end())));
+                }
+            TU_ARMA(StaticString, e) {
+                add(::std::hash<::std::string>()(e));
+                }
+            TU_ARMA(Generic, e) {
+                add(e.binding);
+                }
+            }
+            return ::MIR::visit::Visitor::visit_const(c);
+        }
+        bool visit_rvalue(const ::MIR::RValue& rv) override {
+            add(rv.tag());
+            TU_MATCH_HDRA( (rv), {)
+            default:
+                break;
+            TU_ARMA(Borrow, e) {
+                add(static_cast<size_t>(e.type));
+                }
+            TU_ARMA(BinOp, e) {
+                add(static_cast<size_t>(e.op));
+                }
+            TU_ARMA(UniOp, e) {
+                add(static_cast<size_t>(e.op));
+                }
+            TU_ARMA(UnionVariant, e) {
+                add(e.index);
+                }
+            TU_ARMA(EnumVariant, e) {
+                add(e.index);
+                }
+            }
+            return ::MIR::visit::Visitor::visit_rvalue(rv);
+        }
+        bool visit_param(const ::MIR::Param& p, ::MIR::visit::ValUsage u) override {
+            add(p.tag());
+            return ::MIR::visit::Visitor::visit_param(p, u);
+        }
+        bool visit_stmt(const ::MIR::Statement& stmt) override {
+            add(stmt.tag());
+            TU_MATCH_HDRA( (stmt), {)
+            default:
+                break;
+            TU_ARMA(SetDropFlag, e) {
+                add(e.idx);
+                add(e.new_val);
+                add(e.other);
+                }
+            TU_ARMA(Drop, e) {
+                add(static_cast<size_t>(e.kind));
+                add(e.flag_idx);
+                }
+            }
+            return ::MIR::visit::Visitor::visit_stmt(stmt);
+        }
+        bool visit_block_id(const ::MIR::BasicBlockId& bb) override {
+            add(bb);
+            return false;
+        }
+        bool visit_terminator(const ::MIR::Terminator& term) override {
+            add(term.tag());
+            if( const auto* e = term.opt_Call() ) {
+                add(e->fcn.tag());
+                if( const auto* ie = e->fcn.opt_Intrinsic() )
+                    add(ie->name);
+            }
+            return ::MIR::visit::Visitor::visit_terminator(term);
+        }
+    };
+
+    size_t get_hash(const FcnInfo& fi)
+    {
+        Hasher  h;
+        h.add(::std::hash<::std::string>()(fi.hir->m_abi));
+        h.add(fi.args->size());
+        for(const auto& a : *fi.args)
+            h.visit_type(a.second);
+        h.visit_type(*fi.ret_ty);
+
+        const auto& mir = *fi.mir;
+        h.add(mir.locals.size());
+        for(const auto& ty : mir.locals)
+            h.visit_type(ty);
+        h.add(mir.drop_flags.size());
+        h.add(mir.blocks.size());
+        for(const auto& bb : mir.blocks)
+        {
+            h.add(bb.statements.size());
+            for(const auto& stmt : bb.statements)
+                h.visit_stmt(stmt);
+            h.visit_terminator(bb.terminator);
+        }
+        return h.h == 0 ? 1 : h.h;
+    }
+    bool is_equal(const FcnInfo& a, const FcnInfo& b)
+    {
+        if( a.hir->m_abi != b.hir->m_abi )
+            return false;
+        if( *a.ret_ty != *b.ret_ty )
+            return false;
+        if( a.args->size() != b.args->size() )
+            return false;
+        for(size_t i = 0; i < a.args->size(); i ++)
+            if( (*a.args)[i].second != (*b.args)[i].second )
+                return false;
+
+        const auto& ma = *a.mir;
+        const auto& mb = *b.mir;
+        if( ma.locals != mb.locals || ma.drop_flags != mb.drop_flags || ma.blocks.size() != mb.blocks.size() )
+            return false;
+        for(size_t i = 0; i < ma.blocks.size(); i ++)
+        {
+            if( ma.blocks[i].statements != mb.blocks[i].statements )
+                return false;
+            if( !(ma.blocks[i].terminator == mb.blocks[i].terminator) )
+                return false;
+        }
+        return true;
+    }
+
+    /// Rewrites all references to replaced functions
+    struct Redirector: public ::MIR::visit::VisitorMut
+    {
+        const ::std::map<::HIR::Path, const ::HIR::Path*>&  replacements;
+        bool changed = false;
+
+        Redirector(const ::std::map<::HIR::Path, const ::HIR::Path*>& replacements):
+            replacements(replacements)
+        {
+        }
+
+        bool visit_lvalue(::MIR::LValue& lv, ::MIR::visit::ValUsage u) override {
+            return false;
+        }
+        void visit_path(::HIR::Path& p) override {
+            auto it = replacements.find(p);
+            if( it != replacements.end() ) {
+                p = it->second->clone();
+                changed = true;
+            }
+        }
+    };
+}
+
+void Trans_Deduplicate(const ::HIR::Crate& crate, TransList& list)
+{
+    TRACE_FUNCTION;
+    // Each pass can expose more duplicates (callers of merged functions), but the returns diminish quickly
+    const unsigned MAX_PASSES = 4;
+
+    ::std::vector<FcnInfo>  fcns;
+    for(auto& ent : list.m_functions)
+    {
+        auto& e = *ent.second;
+        if( !e.ptr->m_code.m_mir || e.force_prototype )
+            continue ;
+        FcnInfo fi;
+        fi.path = &ent.first;
+        fi.hir = e.ptr;
+        // Same selection of the body as codegen
+        if( e.monomorphised.code ) {
+            fi.ret_ty = &e.monomorphised.ret_ty;
+            fi.args = &e.monomorphised.arg_tys;
+            fi.mir = &*e.monomorphised.code;
+        }
+        else {
+            fi.ret_ty = &e.ptr->m_return;
+            fi.args = &e.ptr->m_args;
+            fi.mir = &*const_cast<::HIR::Function*>(e.ptr)->m_code.m_mir;
+        }
+        fi.hash = 0;
+        // Functions without HIR are from other crates, and are emitted with internal linkage
+        fi.is_candidate = !static_cast<bool>(e.ptr->m_code) && e.ptr->m_linkage.name == "";
+        fi.is_replaced = false;
+        fcns.push_back(fi);
+    }
+
+    size_t n_replaced = 0;
+    for(unsigned pass = 0; pass < MAX_PASSES; pass ++)
+    {
+        // Group by hash, the first instance seen is kept (and non-candidates are always kept)
+        ::std::map<::HIR::Path, const ::HIR::Path*>  replacements;
+        ::std::unordered_map<size_t, ::std::vector<const FcnInfo*>>  buckets;
+        for(auto& fi : fcns)
+        {
+            if( fi.is_replaced )
+                continue ;
+            if( fi.hash == 0 )
+                fi.hash = get_hash(fi);
+            auto& bucket = buckets[fi.hash];
+            const FcnInfo* existing = nullptr;
+            if( fi.is_candidate )
+            {
+                for(const auto* other : bucket)
+                {
+                    if( is_equal(*other, fi) ) {
+                        existing = other;
+                        break;
+                    }
+                }
+            }
+            if( existing )
+            {
+                DEBUG(*fi.path << " = " << *existing->path);
+                replacements.insert(::std::make_pair( fi.path->clone(), existing->path ));
+                fi.is_replaced = true;
+            }
+            else
+            {
+                bucket.push_back(&fi);
+            }
+        }
+        DEBUG("Pass " << pass << ": " << replacements.size() << " duplicates");
+        if( replacements.empty() )
+            break;
+        n_replaced += replacements.size();
+
+        // Redirect references, and re-hash anything that changed
+        // - Replaced functions are also updated, as they're kept if referenced from a static
+        for(auto& fi : fcns)
+        {
+            Redirector  v { replacements };
+            for(auto& bb : fi.mir->blocks)
+            {
+                for(auto& stmt : bb.statements)
+                    v.visit_stmt(stmt);
+                v.visit_terminator(bb.terminator);
+            }
+            if( v.changed )
+            {
+                fi.mir->trans_enum_state = ::MIR::EnumCachePtr();   // Clear MIR enum cache
+                fi.hash = 0;
+            }
+        }
+    }
+    DEBUG(n_replaced << " functions redirected");
+}
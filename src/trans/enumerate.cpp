@@ -412,72 +412,140 @@ TransList Trans_Enumerate_Public(::HIR::Crate& crate)
 
 void Trans_Enumerate_Cleanup(const ::HIR::Crate& crate, TransList& list)
 {
-    // NOTE: Disabled, as full filtering is nigh-on impossible
-    // - Could do partial filtering of unused locally generated versions of trait impls and inlines
-#if 0
-    EnumState   state { crate };
-
+    // Whole-crate reachability over the post-inlining MIR, removes items that are no longer referenced
+    // - Only items emitted with internal linkage (functions from other crates, which are emitted as `static`) and
+    //   auto-generated (weak) vtables are candidates, everything else may be referenced externally and is a root.
+    // - Drop glue, impls of lang item traits, and lang items can be referenced implicitly by codegen, so are kept.
+    TRACE_FUNCTION;
 
-    // Visit every function used and determine the items it uses
-    // - This doesn't consider the function itself as used, so unused functions will be pruned
-    Trans_Params    tp;
+    ::std::set<::HIR::SimplePath>   lang_items;
+    for(const auto& e : crate.m_lang_items)
+        lang_items.insert(e.second);
+    auto is_implicitly_used = [&](const ::HIR::Path& p)->bool {
+        TU_MATCH_HDRA( (p.m_data), {)
+        TU_ARMA(Generic, pe) {
+            return lang_items.count(pe.m_path) > 0;
+            }
+        TU_ARMA(UfcsInherent, pe) {
+            return pe.item == "#drop_glue";
+            }
+        TU_ARMA(UfcsKnown, pe) {
+            return lang_items.count(pe.trait.m_path) > 0;
+            }
+        TU_ARMA(UfcsUnknown, pe) {
+            }
+        }
+        return false;
+        };
+    ::std::set<const ::HIR::Static*>    auto_statics;
+    for(const auto& s : list.m_auto_statics)
+        auto_statics.insert(s.get());
+
+    // Items are matched by mangled name (the symbol that codegen emits), so path representation differences don't matter
+    struct Item {
+        const TransList_Function*   fcn;
+        const ::HIR::Path*  static_path;
+        const TransList_Static* stat;
+        bool    reached;
+    };
+    ::std::map<::std::string, Item>  items;
+    ::std::vector<Item*>    queue;
+    // Item for each entry in `list.m_functions`/`list.m_statics` (in iteration order), so each name is only mangled once
+    ::std::vector<const Item*>  fcn_items;
+    ::std::vector<const Item*>  static_items;
     for(const auto& ent : list.m_functions)
     {
-        const MIR::Function* mir;
-        if( ent.second->monomorphised.code )
-        {
-            mir = &*ent.second->monomorphised.code;
+        const auto& fcn = *ent.second->ptr;
+        bool is_candidate = !static_cast<bool>(fcn.m_code) && fcn.m_linkage.name == "" && !is_implicitly_used(ent.first);
+        auto& it = items[FMT(Trans_Mangle(ent.first))];
+        it = Item { ent.second.get(), nullptr, nullptr, !is_candidate };
+        fcn_items.push_back(&it);
+        if( it.reached )
+            queue.push_back(&it);
+    }
+    for(const auto& ent : list.m_statics)
+    {
+        bool is_candidate = auto_statics.count(ent.second->ptr) > 0;
+        auto& it = items[FMT(Trans_Mangle(ent.first))];
+        it = Item { nullptr, &ent.first, ent.second.get(), !is_candidate };
+        static_items.push_back(&it);
+        if( it.reached )
+            queue.push_back(&it);
+    }
+
+    auto mark = [&](const ::HIR::Path& p) {
+        auto it = items.find(FMT(Trans_Mangle(p)));
+        if( it != items.end() && !it->second.reached ) {
+            DEBUG("Reached " << p);
+            it->second.reached = true;
+            queue.push_back(&it->second);
         }
-        else if( ent.second->ptr->m_code.m_mir )
+        };
+    while( !queue.empty() )
+    {
+        const auto& item = *queue.back();
+        queue.pop_back();
+
+        if( item.fcn )
         {
-            mir = &*ent.second->ptr->m_code.m_mir;
+            if( !item.fcn->ptr->m_code.m_mir || item.fcn->force_prototype )
+                continue;
+            // Use the same body that codegen will emit
+            const auto& mir = item.fcn->monomorphised.code ? *item.fcn->monomorphised.code : *item.fcn->ptr->m_code.m_mir;
+            MIR::EnumCache  ec;
+            Trans_Enumerate_FillFrom_MIR(ec, mir);
+            // NOTE: `Constant::Const` has been expanded by this point (codegen rejects it), so all references are visible
+            for(const auto* p : ec.paths)
+                mark(*p);
         }
         else
         {
-            continue;
-        }
-
-        MIR::EnumCache  ec;
-        Trans_Enumerate_FillFrom_MIR(ec, *mir);
-        ec.apply(state, tp);
-    }
-    for(const auto& ent : list.m_statics)
-    {
-        const auto& pp = ent.second->pp;
-        const auto& item = *ent.second->ptr;
-        if( ! item.m_value_res.is_Invalid() )
-        {
-            Trans_Enumerate_FillFrom_Literal(state, item.m_value_res, pp);
+            const auto& stat = *item.stat->ptr;
+            const EncodedLiteral* lit = nullptr;
+            if( stat.m_params.is_generic() )
+                lit = &stat.m_monomorph_cache.at(*item.static_path);
+            else if( stat.m_value_generated && !stat.m_no_emit_value )
+                lit = &stat.m_value_res;
+            if( lit )
+            {
+                for(const auto& r : lit->relocations)
+                    if( r.p )
+                        mark(*r.p);
+            }
         }
     }
 
-    // Remove any item in `list.m_functions` that doesn't appear in `state.rv.m_functions`
-    for(auto it = list.m_functions.begin(); it != list.m_functions.end();)
+    // Remove anything that wasn't reached
+    size_t n_fcns = 0, n_statics = 0;
+    size_t idx = 0;
+    for(auto it = list.m_functions.begin(); it != list.m_functions.end(); idx ++)
     {
-        auto it2 = state.rv.m_functions.find(it->first);
-        // TODO: Only remove if it is not exported
-        // - externally reachable
-        // - used by exported generic
-        // - part of a local trait impl
-        if( it2 == state.rv.m_functions.end() && false )
+        if( !fcn_items[idx]->reached )
         {
             DEBUG("Remove " << it->first);
             it = list.m_functions.erase(it);
+            n_fcns ++;
         }
         else
         {
-            DEBUG("Keep " << it->first);
             ++ it;
         }
     }
-
-    // Sanity check: all items in `state.rv.m_functions` must exist in `list.m_functions`
-    for(const auto& e : state.rv.m_functions)
+    idx = 0;
+    for(auto it = list.m_statics.begin(); it != list.m_statics.end(); idx ++)
     {
-        auto it = list.m_functions.find(e.first);
-        ASSERT_BUG(Span(), it != list.m_functions.end(), "Enumerate Error - New function appeared after monomorphisation - " << e.first);
+        if( !static_items[idx]->reached )
+        {
+            DEBUG("Remove " << it->first);
+            it = list.m_statics.erase(it);
+            n_statics ++;
+        }
+        else
+        {
+            ++ it;
+        }
     }
-#endif
+    DEBUG("Removed " << n_fcns << " functions and " << n_statics << " statics");
 }
 
 /// Common post-processing
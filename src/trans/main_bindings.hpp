@@ -40,8 +40,13 @@ extern TransList Trans_Enumerate_Public(::HIR::Crate& crate);
 /// Re-run enumeration on monomorphised functions, removing now-unused items
 extern void Trans_Enumerate_Cleanup(const ::HIR::Crate& crate, TransList& list);
 
+/// Redirect references to functions with identical code to a single instance (run before `Trans_Enumerate_Cleanup`)
+extern void Trans_Deduplicate(const ::HIR::Crate& crate, TransList& list);
+
 extern void Trans_AutoImpls(::HIR::Crate& crate, TransList& trans_list);
 
 extern void Trans_Monomorphise_List(const ::HIR::Crate& crate, TransList& list);
 
-extern void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const TransOptions& opt, const ::HIR::Crate& crate, const TransList& list, const ::std::string& hir_file);
+/// Emit code for all items in the list
+/// NOTE: Monomorphised MIR is released as each function is emitted, so the list is no longer complete afterwards
+extern void Trans_Codegen(const ::std::string& outfile, CodegenOutput out_ty, const TransOptions& opt, const ::HIR::Crate& crate, TransList& list, const ::std::string& hir_file);
@@ -6,11 +6,19 @@
 #include <module_tree.hpp>
 #include "codegen.hpp"
 #include <algorithm>
+#include <thread>
+#include <atomic>
+#include <cstdlib>  // std::system
+#include <cstring>
 
 struct Opts
 {
     ::std::string   infile;
     ::std::string   outfile;
+    // Number of output files (each emitted on its own thread), one means a single self-contained file
+    unsigned    jobs = 1;
+    // Optional compiler command, run on each output file in parallel (e.g. `cc -c -O2`)
+    ::std::string   compile_cmd;
 
     int parse(int argc, const char* argv[]);
     void show_help(const char* prog) const;
@@ -181,25 +189,145 @@ int main(int argc, const char* argv[])
         });
 
     // 3. Emit C code
-    Codegen_C codegen(opts.outfile.c_str());
-    //  - Emit types
-    //  - Emit function/static prototypes
-    tree.iterate_statics([&](RcString name, const Static& s) {
-        codegen.emit_static_proto(name, s);
-        });
-    tree.iterate_functions([&](RcString name, const Function& f) {
-        codegen.emit_function_proto(name, f);
-        });
-    //  - Emit statics
-    tree.iterate_statics([&](RcString name, const Static& s) {
-        codegen.emit_static(name, s);
-        });
-    //  - Emit functions
-    tree.iterate_functions([&](RcString name, const Function& f) {
-        codegen.emit_function(name, tree, f);
-        });
+    if( opts.jobs <= 1 )
+    {
+        Codegen_C codegen(opts.outfile.c_str());
+        //  - Emit types
+        //  - Emit function/static prototypes
+        tree.iterate_statics([&](RcString name, const Static& s) {
+            codegen.emit_static_proto(name, s);
+            });
+        tree.iterate_functions([&](RcString name, const Function& f) {
+            codegen.emit_function_proto(name, f);
+            });
+        //  - Emit statics
+        tree.iterate_statics([&](RcString name, const Static& s) {
+            codegen.emit_static(name, s);
+            });
+        //  - Emit functions
+        tree.iterate_functions([&](RcString name, const Function& f) {
+            codegen.emit_function(name, tree, f);
+            });
 
-    return 0;
+        if( opts.compile_cmd != "" )
+        {
+            auto cmd = opts.compile_cmd + " " + opts.outfile + " -o " + opts.outfile + ".o";
+            if( ::std::system(cmd.c_str()) != 0 )
+            {
+                ::std::cerr << "Compiling " << opts.outfile << " failed" << ::std::endl;
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    // Split output: types and prototypes go in a shared header, function bodies are partitioned over `jobs` files
+    // - `foo.c` becomes `foo.h` and `foo.0.c` ... `foo.N.c`
+    auto base = opts.outfile;
+    if( base.size() > 2 && base.compare(base.size() - 2, 2, ".c") == 0 )
+        base.resize(base.size() - 2);
+    auto header_path = base + ".h";
+    auto header_name = header_path.substr(header_path.find_last_of("/\\") + 1);
+
+    {
+        Codegen_C codegen(header_path.c_str());
+        codegen.emit_header_start();
+        tree.iterate_statics([&](RcString name, const Static& s) {
+            codegen.emit_static_proto(name, s);
+            });
+        tree.iterate_functions([&](RcString name, const Function& f) {
+            codegen.emit_function_proto(name, f);
+            });
+    }
+
+    // Partition by (approximate) body size, assigning the largest items first to the least loaded file.
+    // NOTE: Names are taken by pointer into the tree, as RcString's refcount isn't atomic.
+    struct Partition {
+        size_t  weight = 0;
+        ::std::vector<std::pair<size_t, std::pair<const RcString*, const Static*>>>   statics;
+        ::std::vector<std::pair<size_t, std::pair<const RcString*, const Function*>>>   functions;
+    };
+    ::std::vector<Partition>    parts(opts.jobs);
+    {
+        struct Item {
+            size_t  weight;
+            size_t  index;
+            const RcString* name;
+            const Static*   s;
+            const Function* f;
+        };
+        ::std::vector<Item> items;
+        tree.iterate_statics([&](const RcString& name, const Static& s) {
+            items.push_back(Item { 1, items.size(), &name, &s, nullptr });
+            });
+        tree.iterate_functions([&](const RcString& name, const Function& f) {
+            size_t  w = 1;
+            for(const auto& bb : f.m_mir.blocks)
+                w += 1 + bb.statements.size();
+            items.push_back(Item { w, items.size(), &name, nullptr, &f });
+            });
+        ::std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b){ return a.weight > b.weight; });
+        for(const auto& i : items)
+        {
+            auto& p = *::std::min_element(parts.begin(), parts.end(), [](const Partition& a, const Partition& b){ return a.weight < b.weight; });
+            p.weight += i.weight;
+            if( i.s )
+                p.statics.push_back(::std::make_pair(i.index, ::std::make_pair(i.name, i.s)));
+            else
+                p.functions.push_back(::std::make_pair(i.index, ::std::make_pair(i.name, i.f)));
+        }
+        // Keep the tree's ordering within each file (so output is deterministic)
+        for(auto& p : parts)
+        {
+            ::std::sort(p.statics.begin(), p.statics.end(), [](const auto& a, const auto& b){ return a.first < b.first; });
+            ::std::sort(p.functions.begin(), p.functions.end(), [](const auto& a, const auto& b){ return a.first < b.first; });
+        }
+    }
+
+    // Emit (and compile) each partition on its own thread, the module tree is only read from here on
+    ::std::atomic<bool> failed { false };
+    ::std::vector<::std::thread>    threads;
+    for(unsigned i = 0; i < opts.jobs; i ++)
+    {
+        threads.push_back(::std::thread([&,i]() {
+            auto path = base + "." + ::std::to_string(i) + ".c";
+            try
+            {
+                Codegen_C codegen(path.c_str());
+                codegen.emit_include(header_name);
+                for(const auto& e : parts[i].statics)
+                    codegen.emit_static(*e.second.first, *e.second.second);
+                for(const auto& e : parts[i].functions)
+                    codegen.emit_function(*e.second.first, tree, *e.second.second);
+            }
+            catch(const DebugExceptionTodo& /*e*/)
+            {
+                ::std::cerr << path << ": TODO Hit" << ::std::endl;
+                failed = true;
+                return ;
+            }
+            catch(const DebugExceptionError& /*e*/)
+            {
+                ::std::cerr << path << ": Error encountered" << ::std::endl;
+                failed = true;
+                return ;
+            }
+
+            if( opts.compile_cmd != "" )
+            {
+                auto cmd = opts.compile_cmd + " " + path + " -o " + path + ".o";
+                if( ::std::system(cmd.c_str()) != 0 )
+                {
+                    ::std::cerr << "Compiling " << path << " failed" << ::std::endl;
+                    failed = true;
+                }
+            }
+            }));
+    }
+    for(auto& t : threads)
+        t.join();
+
+    return failed ? 1 : 0;
 }
 
 int Opts::parse(int argc, const char* argv[])
@@ -233,6 +361,20 @@ int Opts::parse(int argc, const char* argv[])
             }
             switch(arg[1])
             {
+            case 'o':
+                if( argidx + 1 == argc ) {
+                    ::std::cerr << "Option -o requires an argument" << ::std::endl;
+                    return 1;
+                }
+                this->outfile = argv[++argidx];
+                break;
+            case 'j':
+                if( argidx + 1 == argc ) {
+                    ::std::cerr << "Option -j requires an argument" << ::std::endl;
+                    return 1;
+                }
+                this->jobs = ::std::strtoul(argv[++argidx], nullptr, 10);
+                break;
             case 'h':
                 this->show_help(argv[0]);
                 exit(0);
@@ -250,6 +392,13 @@ int Opts::parse(int argc, const char* argv[])
             }
             //else if( ::std::strcmp(arg, "--target") == 0 ) {
             //}
+            else if( ::std::strcmp(arg, "--compile") == 0 ) {
+                if( argidx + 1 == argc ) {
+                    ::std::cerr << "Option " << arg << " requires an argument" << ::std::endl;
+                    return 1;
+                }
+                this->compile_cmd = argv[++argidx];
+            }
             else {
                 ::std::cerr << "Unexpected option " << arg << ::std::endl;
                 return 1;
@@ -271,6 +420,10 @@ int Opts::parse(int argc, const char* argv[])
     {
         this->outfile = "a.c";
     }
+    if( this->jobs == 0 )
+    {
+        this->jobs = ::std::max(1u, ::std::thread::hardware_concurrency());
+    }
 
     return 0;
 }
@@ -278,4 +431,7 @@ int Opts::parse(int argc, const char* argv[])
 void Opts::show_help(const char* prog) const
 {
     ::std::cout << "USAGE: " << prog << " <infile> <... args>" << ::std::endl;
+    ::std::cout << "-o <file>         : Output file (default a.c)" << ::std::endl;
+    ::std::cout << "-j <n>            : Split output into <n> files emitted in parallel, sharing a header (0 = one per core)" << ::std::endl;
+    ::std::cout << "--compile <cmd>   : Compile each output file with `<cmd> <file> -o <file>.o` (in parallel)" << ::std::endl;
 }
@@ -11,6 +11,15 @@ Codegen_C::~Codegen_C()
 {
 }
 
+void Codegen_C::emit_header_start()
+{
+    m_of << "#pragma once\n";
+}
+void Codegen_C::emit_include(const ::std::string& header_name)
+{
+    m_of << "#include \"" << header_name << "\"\n";
+}
+
 void Codegen_C::emit_type_proto(const HIR::TypeRef& ty)
 {
     TRACE_FUNCTION_R(ty, ty);
@@ -13,6 +13,11 @@ public:
     Codegen_C(const char* outfile);
     ~Codegen_C();
 
+    /// Start of a header shared by split output files
+    void emit_header_start();
+    /// Include a header (from the same directory)
+    void emit_include(const ::std::string& header_name);
+
     void emit_type_proto(const HIR::TypeRef& ty);
     void emit_static_proto(const RcString& name, const Static& s);
     void emit_function_proto(const RcString& name, const Function& s);
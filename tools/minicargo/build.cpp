@@ -16,6 +16,7 @@
 #include "stringlist.h"
 #include "jobs.hpp"
 #include "file_timestamp.h"
+#include "fingerprint.h"
 #include "os.hpp"
 #include <fstream>
 #include <cassert>
@@ -33,17 +34,34 @@
 #include <target_detect.h>  // tools/common/target_detect.h
 #define HOST_TARGET DEFAULT_TARGET_NAME
 
+class Job_Build;
+
 struct RunState
 {
     BuildOptions&   m_opts;
     const helpers::path& m_compiler_path;
     bool m_is_cross_compiling;
+    /// Shared artifact cache directory (from `MINICARGO_CACHE_DIR`), invalid if the cache is disabled
+    helpers::path   m_cache_dir;
+    /// Hash of the compiler executable (only populated when using fingerprints or the artifact cache)
+    ContentHash m_compiler_hash;
+    /// Cache of input file hashes, only valid before any jobs are run
+    mutable ::std::unordered_map<::std::string, ContentHash>  m_file_hash_cache;
 
     RunState(BuildOptions& opts, bool is_cross_compiling)
         : m_opts(opts)
         , m_compiler_path(os_support::get_mrustc_path())
         , m_is_cross_compiling(is_cross_compiling)
-    {}
+    {
+        if( const char* e = getenv("MINICARGO_CACHE_DIR") ) {
+            if( *e != '\0' ) {
+                m_cache_dir = helpers::path(e).to_absolute();
+            }
+        }
+        if( m_opts.use_fingerprints || m_cache_dir.is_valid() ) {
+            m_compiler_hash = ContentHash::for_file(m_compiler_path);
+        }
+    }
 
     bool is_rustc() const {
         return m_compiler_path.basename() == "rustc" || m_compiler_path.basename() == "rustc.exe";
@@ -65,7 +83,9 @@ struct RunState
         return rv;
     }
 
+    bool job_needs_rebuild(const Job_Build& job) const;
     bool outfile_needs_rebuild(const helpers::path& outfile) const;
+    bool fingerprint_needs_rebuild(const helpers::path& outfile, const ContentHash& command_hash) const;
 
     /// Get the crate suffix (stuff added to the crate name to form the filename)
     ::std::string get_crate_suffix(const PackageManifest& manifest) const;
@@ -106,6 +126,17 @@ protected:
 
     void push_args_common(StringList& args, const helpers::path& outfile, bool is_for_host) const;
 
+    /// Hash of the command passed to `start`, saved in the fingerprint on completion
+    ContentHash m_command_hash;
+    /// Artifact cache entry for this job (set by `try_complete_cached` if the output can be cached)
+    helpers::path   m_cache_entry;
+
+    /// Get the artifact cache key for this job, returns false if the output can't be shared
+    virtual bool get_cache_key(ContentHash& out_key) const { return false; }
+    ::std::string make_portable(const helpers::path& p) const;
+    helpers::path from_portable(const ::std::string& p) const;
+    void save_fingerprint(const helpers::path& outfile) const;
+    void save_to_cache(const helpers::path& outfile) const;
 public:
     const std::string& name() const override {
         return m_name;
@@ -116,7 +147,14 @@ public:
     bool is_runnable() const override {
         return true;
     }
+    RunnableJob start() override {
+        auto rv = get_command();
+        m_command_hash = ContentHash::for_command(rv);
+        return rv;
+    }
     bool complete(bool was_success) override;
+    bool try_complete_cached() override;
+    virtual RunnableJob get_command() const = 0;
     virtual helpers::path get_outfile() const = 0;
 };
 class Job_BuildTarget: public Job_Build
@@ -133,8 +171,10 @@ public:
     }
     helpers::path   m_build_script;
 
-    RunnableJob start() override;
+    RunnableJob get_command() const override;
     helpers::path get_outfile() const override;
+protected:
+    bool get_cache_key(ContentHash& out_key) const override;
 };
 class Job_BuildScript: public Job_Build
 {
@@ -144,7 +184,7 @@ public:
     {
     }
 
-    RunnableJob start() override;
+    RunnableJob get_command() const override;
     helpers::path get_outfile() const override;
 };
 class Job_RunScript: public Job
@@ -152,13 +192,16 @@ class Job_RunScript: public Job
     const RunState&  parent;
     const PackageManifest&  m_manifest;
     const ::std::string m_name;
+    // NOTE: Stored so the executable name passed to `RunnableJob` stays valid
+    const helpers::path   m_script_exe_abs;
     // Populated on `start`
-    helpers::path   m_script_exe_abs;
+    ContentHash m_command_hash;
 public:
     Job_RunScript(const RunState& parent, const PackageManifest& manifest)
         : parent(parent)
         , m_manifest(manifest)
         , m_name(parent.get_key(manifest, false, false)+" (script run)")
+        , m_script_exe_abs(helpers::path(parent.get_build_script_exe(manifest)).to_absolute())
     {
     }
     ::std::vector<std::string>  m_dependencies;
@@ -179,6 +222,7 @@ public:
     RunnableJob start() override;
     bool complete(bool was_success) override;
 
+    RunnableJob get_command() const;
     helpers::path get_script_exe() const;
     helpers::path get_outfile() const;
 };
@@ -292,9 +336,10 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs, bool dry_run)
 
     struct ConvertState {
         JobList& joblist;
+        bool use_fingerprints;
         ::std::unordered_map<std::string,bool>  items_built;
         ::std::unordered_map<std::string,Timestamp>   items_notbuilt;
-        ConvertState(JobList& joblist): joblist(joblist) {}
+        ConvertState(JobList& joblist, bool use_fingerprints): joblist(joblist), use_fingerprints(use_fingerprints) {}
 
         bool handle_dep(std::vector<std::string>& job_deps, const Timestamp& output_ts, const std::string& k) const {
             if( items_built.find(k) != items_built.end() ) {
@@ -308,6 +353,10 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs, bool dry_run)
                     ::std::cerr << "ASSERTION Failed: items_notbuilt.find('"<<k<<"') != items_notbuilt.end" <<std::endl;
                     abort();
                 }
+                // When using fingerprints, the dependency's output is an input listed in the fingerprint (via the depfile)
+                if( use_fingerprints ) {
+                    return false;
+                }
                 // This crate's output is older than the depencency, force a rebuild
                 return output_ts < it->second;
             }
@@ -347,7 +396,7 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs, bool dry_run)
                     auto job_bs_build = ::std::make_unique<Job_BuildScript>(run_state, p);
                     
                     auto script_ts = Timestamp::for_file(job_bs_build->get_outfile());
-                    bool bs_is_dirty = run_state.outfile_needs_rebuild(job_bs_build->get_outfile());
+                    bool bs_is_dirty = run_state.job_needs_rebuild(*job_bs_build);
                     p.iter_build_dependencies([&](const PackageRef& dep) {
                         if( !dep.is_disabled() )
                         {
@@ -396,7 +445,15 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs, bool dry_run)
                             bs_is_dirty |= this->handle_dep(job_bs_run->m_dependencies, output_ts, k);
                         }
                     });
-                    bool bs_needs_run = bs_is_dirty || output_ts < script_ts;
+                    bool bs_needs_run = bs_is_dirty;
+                    if( !bs_needs_run ) {
+                        if( run_state.m_opts.use_fingerprints ) {
+                            bs_needs_run = run_state.fingerprint_needs_rebuild(build_script, ContentHash::for_command(job_bs_run->get_command()));
+                        }
+                        else {
+                            bs_needs_run = output_ts < script_ts;
+                        }
+                    }
                     auto rv = bs_needs_run ? job_bs_run->name() : ::std::string();
                     this->add_job(std::move(job_bs_run), output_ts, bs_needs_run);
                     // If the script is not being run, then it still needs to be loaded
@@ -412,7 +469,7 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs, bool dry_run)
                 return "";
             }
         }
-    } convert_state(runner);
+    } convert_state(runner, opts.use_fingerprints);
     
     for(const auto& e : m_list)
     {
@@ -422,13 +479,17 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs, bool dry_run)
         DEBUG("> Considering " << job->name());
 
         auto output_ts = Timestamp::for_file(job->get_outfile());
-        bool is_dirty = run_state.outfile_needs_rebuild(job->get_outfile());
+        bool is_dirty;
         // Handle build script
+        // - Done before checking the output, as the command line depends on the script's output
         auto bs_job_name = convert_state.handle_build_script(run_state, p, opts.build_script_overrides, job->m_build_script, e.is_host);
         if( bs_job_name != "" ) {
             job->m_dependencies.push_back(bs_job_name);
             is_dirty = true;
         }
+        else {
+            is_dirty = run_state.job_needs_rebuild(*job);
+        }
         // Check dependencies
         p.iter_main_dependencies([&](const PackageRef& dep) {
             if( !dep.is_disabled() )
@@ -452,7 +513,7 @@ bool BuildList::build(BuildOptions opts, unsigned num_jobs, bool dry_run)
         const bool is_host = !cross_compiling;
         auto job = ::std::make_unique<Job_BuildTarget>(run_state, m_root_manifest, target, is_host);
         auto output_ts = Timestamp::for_file(job->get_outfile());
-        bool is_dirty = run_state.outfile_needs_rebuild(job->get_outfile());
+        bool is_dirty = run_state.job_needs_rebuild(*job);
         if( m_root_manifest.has_library() ) {
             auto k = run_state.get_key(m_root_manifest, false, is_host);
             is_dirty |= convert_state.handle_dep(job->m_dependencies, output_ts, k);
@@ -597,6 +658,29 @@ namespace {
         return rv;
     }
 
+    bool copy_file(const helpers::path& src, const helpers::path& dst)
+    {
+        ::std::ifstream ifs(src.str(), ::std::ios::binary);
+        if( !ifs.good() )
+            return false;
+        // Copy to a temporary then rename, so the destination is never seen half-written
+        auto tmp = make_temp_path(dst);
+        {
+            ::std::ofstream ofs(tmp.str(), ::std::ios::binary);
+            ofs << ifs.rdbuf();
+            if( !ofs.good() ) {
+                ofs.close();
+                remove(tmp.str().c_str());
+                return false;
+            }
+        }
+        if( !replace_file(tmp, dst) ) {
+            remove(tmp.str().c_str());
+            return false;
+        }
+        return true;
+    }
+
     std::string escape_dashes(const std::string& s) {
         std::string rv;
         for(char c : s)
@@ -642,6 +726,49 @@ namespace {
     }
 }
 
+bool RunState::job_needs_rebuild(const Job_Build& job) const
+{
+    if( m_opts.use_fingerprints ) {
+        return fingerprint_needs_rebuild(job.get_outfile(), ContentHash::for_command(job.get_command()));
+    }
+    else {
+        return outfile_needs_rebuild(job.get_outfile());
+    }
+}
+bool RunState::fingerprint_needs_rebuild(const helpers::path& outfile, const ContentHash& command_hash) const
+{
+    if( Timestamp::for_file(outfile) == Timestamp::infinite_past() ) {
+        // Rebuild (missing)
+        DEBUG("Building " << outfile << " - Missing");
+        return true;
+    }
+    Fingerprint fp;
+    if( !fp.load(Fingerprint::path_for(outfile)) ) {
+        DEBUG("Building " << outfile << " - No fingerprint");
+        return true;
+    }
+    if( !getenv("MINICARGO_IGNTOOLS") && fp.compiler != m_compiler_hash ) {
+        DEBUG("Building " << outfile << " - Compiler changed (" << fp.compiler << " != " << m_compiler_hash << ")");
+        return true;
+    }
+    if( fp.command != command_hash ) {
+        DEBUG("Building " << outfile << " - Command line changed (" << fp.command << " != " << command_hash << ")");
+        return true;
+    }
+    for(const auto& i : fp.inputs)
+    {
+        auto it = m_file_hash_cache.find(i.first);
+        if( it == m_file_hash_cache.end() ) {
+            it = m_file_hash_cache.insert(::std::make_pair(i.first, ContentHash::for_file(i.first))).first;
+        }
+        if( it->second != i.second ) {
+            DEBUG("Rebuilding " << outfile << ", " << i.first << " changed (" << i.second << " != " << it->second << ")");
+            return true;
+        }
+    }
+    DEBUG("Not building " << outfile << " - fingerprint matches");
+    return false;
+}
 bool RunState::outfile_needs_rebuild(const helpers::path& outfile) const
 {
     auto ts_result = Timestamp::for_file(outfile);
@@ -752,12 +879,172 @@ bool RunState::outfile_needs_rebuild(const helpers::path& outfile) const
 
 bool Job_Build::complete(bool was_success)
 {
+    auto outfile = get_outfile();
+    auto fp_path = Fingerprint::path_for(outfile);
+    // Always remove the old fingerprint, it's stale now
+    remove(fp_path.str().c_str());
     if(!was_success) {
         // On failure, remove the output (to force a rebuild next time)
-        remove(get_outfile().str().c_str());
+        remove(outfile.str().c_str());
+    }
+    else {
+        if( parent.m_opts.use_fingerprints ) {
+            save_fingerprint(outfile);
+        }
+        if( m_cache_entry.is_valid() ) {
+            save_to_cache(outfile);
+        }
+    }
+    return true;
+}
+void Job_Build::save_fingerprint(const helpers::path& outfile) const
+{
+    auto depfile_ents = load_depfile(outfile + ".d");
+    auto it = depfile_ents.find(outfile);
+    // If there's no depfile, then don't emit a fingerprint (forces a rebuild next time)
+    if( it != depfile_ents.end() )
+    {
+        Fingerprint fp;
+        fp.compiler = parent.m_compiler_hash;
+        fp.command = m_command_hash;
+        for(const auto& f : it->second)
+        {
+            fp.inputs.push_back(::std::make_pair(f.str(), ContentHash::for_file(f)));
+        }
+        fp.save(Fingerprint::path_for(outfile));
+    }
+}
+
+// Paths stored in the artifact cache are relative to either the package directory or the output directory
+// - Allows workspaces in different locations to share cache entries
+::std::string Job_Build::make_portable(const helpers::path& p) const
+{
+    auto abs = p.to_absolute().str();
+    auto strip_prefix = [&](const helpers::path& base, std::string& out)->bool {
+        auto b = base.to_absolute().str();
+        if( abs.size() > b.size() && abs.compare(0, b.size(), b) == 0 && (abs[b.size()] == '/' || abs[b.size()] == '\\') ) {
+            out = abs.substr(b.size() + 1);
+            return true;
+        }
+        return false;
+    };
+    ::std::string   rel;
+    if( strip_prefix(m_manifest.directory(), rel) ) {
+        return "pkg:" + rel;
+    }
+    if( strip_prefix(parent.m_opts.output_dir, rel) ) {
+        return "out:" + rel;
+    }
+    return "abs:" + abs;
+}
+helpers::path Job_Build::from_portable(const ::std::string& p) const
+{
+    if( p.compare(0, 4, "pkg:") == 0 ) {
+        return m_manifest.directory().to_absolute() / (p.c_str() + 4);
+    }
+    if( p.compare(0, 4, "out:") == 0 ) {
+        return parent.m_opts.output_dir.to_absolute() / (p.c_str() + 4);
+    }
+    return helpers::path(p.substr(4));
+}
+bool Job_Build::try_complete_cached()
+{
+    m_cache_entry = helpers::path();
+    if( !parent.m_cache_dir.is_valid() )
+        return false;
+    ContentHash key;
+    if( !get_cache_key(key) )
+        return false;
+    m_cache_entry = parent.m_cache_dir / ::format(m_manifest.name(), "-", m_manifest.version(), "-", key).c_str();
+
+    // Check that the entry exists and that all of its inputs match
+    Fingerprint entry_fp;
+    if( !entry_fp.load(m_cache_entry / "inputs.fp") ) {
+        DEBUG("Cache miss for " << m_name << " (" << m_cache_entry << ")");
+        return false;
+    }
+    if( entry_fp.compiler != parent.m_compiler_hash || entry_fp.command != key ) {
+        DEBUG("Cache entry " << m_cache_entry << " doesn't match key");
+        return false;
+    }
+    ::std::vector<helpers::path>    inputs;
+    for(const auto& i : entry_fp.inputs)
+    {
+        auto p = from_portable(i.first);
+        if( ContentHash::for_file(p) != i.second ) {
+            DEBUG("Cache entry " << m_cache_entry << " stale, " << p << " changed");
+            return false;
+        }
+        inputs.push_back(::std::move(p));
+    }
+
+    auto outfile = get_outfile();
+    os_support::mkdir(outfile.parent());
+    if( !copy_file(m_cache_entry / "output", outfile) ) {
+        DEBUG("Cache entry " << m_cache_entry << " missing output");
+        return false;
+    }
+    if( !(Timestamp::for_file(m_cache_entry / "output.hir") == Timestamp::infinite_past()) ) {
+        if( !copy_file(m_cache_entry / "output.hir", outfile + ".hir") ) {
+            remove(outfile.str().c_str());
+            return false;
+        }
+    }
+    // Re-create the depfile using this workspace's paths
+    {
+        ::std::ofstream ofs((outfile + ".d").str());
+        ofs << outfile << ":";
+        for(const auto& p : inputs)
+            ofs << " " << p;
+        ofs << ::std::endl;
+    }
+    m_cache_entry = helpers::path();
+
+    remove(Fingerprint::path_for(outfile).str().c_str());
+    if( parent.m_opts.use_fingerprints ) {
+        m_command_hash = ContentHash::for_command(get_command());
+        save_fingerprint(outfile);
     }
     return true;
 }
+void Job_Build::save_to_cache(const helpers::path& outfile) const
+{
+    auto depfile_ents = load_depfile(outfile + ".d");
+    auto it = depfile_ents.find(outfile);
+    if( it == depfile_ents.end() ) {
+        return ;
+    }
+    ContentHash key;
+    if( !get_cache_key(key) ) {
+        return ;
+    }
+    Fingerprint entry_fp;
+    entry_fp.compiler = parent.m_compiler_hash;
+    entry_fp.command = key;
+    for(const auto& f : it->second)
+    {
+        entry_fp.inputs.push_back(::std::make_pair(make_portable(f), ContentHash::for_file(f)));
+    }
+
+    os_support::mkdir(parent.m_cache_dir);
+    os_support::mkdir(m_cache_entry);
+    // Remove the input list first, so concurrent readers don't see a half-updated entry as valid
+    auto inputs_path = m_cache_entry / "inputs.fp";
+    remove(inputs_path.str().c_str());
+    if( !copy_file(outfile, m_cache_entry / "output") ) {
+        return ;
+    }
+    if( !(Timestamp::for_file(outfile + ".hir") == Timestamp::infinite_past()) ) {
+        if( !copy_file(outfile + ".hir", m_cache_entry / "output.hir") ) {
+            return ;
+        }
+    }
+    else {
+        remove((m_cache_entry / "output.hir").str().c_str());
+    }
+    entry_fp.save(inputs_path);
+    DEBUG("Stored " << outfile << " in cache entry " << m_cache_entry);
+}
 void Job_Build::push_args_common(StringList& args, const helpers::path& outfile, bool is_for_host) const
 {
     args.push_back("-o"); args.push_back(outfile);
@@ -821,7 +1108,65 @@ helpers::path Job_BuildTarget::get_outfile() const
 {
     return parent.get_crate_path(m_manifest, m_target, m_is_for_host, nullptr, nullptr);
 }
-RunnableJob Job_BuildTarget::start()
+bool Job_BuildTarget::get_cache_key(ContentHash& out_key) const
+{
+    // Only libraries are shared, binaries are specific to the workspace
+    if( m_target.m_type != PackageTarget::Type::Lib )
+        return false;
+
+    // Replace workspace-specific paths in the command with placeholders, so equivalent builds in different
+    // workspaces get the same key.
+    auto out_dir = parent.m_opts.output_dir;
+    ::std::vector<::std::pair<::std::string, const char*>>  replacements;
+    replacements.push_back(::std::make_pair(m_manifest.directory().to_absolute().str(), "<pkg>"));
+    replacements.push_back(::std::make_pair(m_manifest.directory().str(), "<pkg>"));
+    replacements.push_back(::std::make_pair(out_dir.to_absolute().str(), "<out>"));
+    replacements.push_back(::std::make_pair(out_dir.str(), "<out>"));
+    ::std::sort(replacements.begin(), replacements.end(), [](const auto& a, const auto& b){ return a.first.size() > b.first.size(); });
+    auto normalise = [&](const char* s)->::std::string {
+        ::std::string   rv = s;
+        for(const auto& r : replacements)
+        {
+            for(size_t pos = rv.find(r.first); pos != ::std::string::npos; pos = rv.find(r.first, pos))
+            {
+                // Only replace whole path prefixes (start of string or after `=`, and followed by a separator or the end)
+                auto end = pos + r.first.size();
+                bool start_ok = (pos == 0 || rv[pos-1] == '=');
+                bool end_ok = (end == rv.size() || rv[end] == '/' || rv[end] == '\\');
+                if( start_ok && end_ok ) {
+                    rv.replace(pos, r.first.size(), r.second);
+                    pos += ::std::strlen(r.second);
+                }
+                else {
+                    pos += 1;
+                }
+            }
+        }
+        return rv;
+    };
+
+    auto cmd = get_command();
+    ContentHash rv;
+    rv.update(parent.m_compiler_hash);
+    for(const auto* a : cmd.args.get_vec())
+        rv.update(normalise(a).c_str());
+    rv.update("");
+    for(auto kv : cmd.env)
+    {
+        rv.update(kv.first);
+        rv.update(normalise(kv.second).c_str());
+    }
+    rv.update("");
+    // Files generated by the build script aren't listed in the depfile, so include them in the key
+    if( m_manifest.build_script() != "" )
+    {
+        auto script_out_dir = parent.get_output_dir(m_is_for_host).to_absolute() / parent.get_build_script_out(m_manifest);
+        rv.update(ContentHash::for_directory(script_out_dir));
+    }
+    out_key = rv;
+    return true;
+}
+RunnableJob Job_BuildTarget::get_command() const
 {
     const char* crate_type;
     ::std::string   crate_suffix;
@@ -933,7 +1278,7 @@ helpers::path Job_BuildScript::get_outfile() const
 {
     return parent.get_build_script_exe(m_manifest);
 }
-RunnableJob Job_BuildScript::start()
+RunnableJob Job_BuildScript::get_command() const
 {
     auto outfile = get_outfile();
 
@@ -978,13 +1323,18 @@ helpers::path Job_RunScript::get_script_exe() const
 RunnableJob Job_RunScript::start()
 {
     auto out_dir = parent.get_output_dir(true) / parent.get_build_script_out(m_manifest);
-    auto out_file = get_outfile();
-    auto script_exe = get_script_exe();
-
-    auto script_exe_abs = script_exe.to_absolute();
-
     // - Run the script and put output in the right dir
     os_support::mkdir(out_dir);
+
+    auto rv = get_command();
+    m_command_hash = ContentHash::for_command(rv);
+    return rv;
+}
+RunnableJob Job_RunScript::get_command() const
+{
+    auto out_dir = parent.get_output_dir(true) / parent.get_build_script_out(m_manifest);
+    auto out_file = get_outfile();
+
     // Environment variables (key-value list)
     StringListKV    env;
     //env.push_back("CARGO_MANIFEST_LINKS", manifest.m_links);
@@ -1015,7 +1365,6 @@ RunnableJob Job_RunScript::start()
     // NOTE: All cfg(foo_bar) become CARGO_CFG_FOO_BAR
     Cfg_ToEnvironment(env);
 
-    m_script_exe_abs = ::std::move(script_exe_abs);
     if( parent.m_opts.emit_mmir )
     {
         StringList  args;
@@ -1032,10 +1381,20 @@ RunnableJob Job_RunScript::start()
 bool Job_RunScript::complete(bool was_success)
 {
     auto out_file = this->get_outfile();
+    auto fp_path = Fingerprint::path_for(out_file);
+    remove(fp_path.str().c_str());
     if(was_success)
     {
         // TODO: Parse the script here? Or just keep the parsing in the downstream build
         const_cast<PackageManifest&>(m_manifest).load_build_script( out_file.str() );
+        if( parent.m_opts.use_fingerprints )
+        {
+            Fingerprint fp;
+            fp.compiler = parent.m_compiler_hash;
+            fp.command = m_command_hash;
+            fp.inputs.push_back(::std::make_pair(m_script_exe_abs.str(), ContentHash::for_file(m_script_exe_abs)));
+            fp.save(fp_path);
+        }
         return true;
     }
     else
@@ -21,6 +21,8 @@ struct BuildOptions
     ::std::vector<::helpers::path>  lib_search_dirs;
     bool emit_mmir = false;
     bool enable_debug = false;
+    /// Use content hashes (stored in `<output>.fp`) instead of timestamps to detect when a rebuild is needed
+    bool use_fingerprints = false;
     const char* target_name = nullptr;  // if null, host is used
     enum class Mode {
         /// Build the binary/library
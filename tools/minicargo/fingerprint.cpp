@@ -0,0 +1,235 @@
+/*
+ * minicargo - MRustC-specific clone of `cargo`
+ * - By John Hodge (Mutabah)
+ *
+ * fingerprint.cpp
+ * - Content-hash based build fingerprints
+ */
+#include "fingerprint.h"
+#include "jobs.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdio>  // remove/rename
+#include <algorithm>    // sort
+#include <atomic>
+#ifdef _WIN32
+# include <Windows.h>
+#else
+# include <dirent.h>
+# include <sys/stat.h>
+# include <unistd.h>    // getpid
+#endif
+
+namespace {
+    void list_files_recursive(const ::helpers::path& base, const ::std::string& rel, ::std::vector<::std::string>& out)
+    {
+        auto dir = rel.empty() ? base : base / rel.c_str();
+#ifdef _WIN32
+        WIN32_FIND_DATAA    data;
+        auto handle = FindFirstFileA((dir / "*").str().c_str(), &data);
+        if( handle == INVALID_HANDLE_VALUE )
+            return ;
+        do {
+            ::std::string   name = data.cFileName;
+            bool is_dir = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+        auto* handle = opendir(dir.str().c_str());
+        if( !handle )
+            return ;
+        while( auto* ent = readdir(handle) )
+        {
+            ::std::string   name = ent->d_name;
+            struct stat s;
+            bool is_dir = stat((dir / name.c_str()).str().c_str(), &s) == 0 && S_ISDIR(s.st_mode);
+#endif
+            if( name == "." || name == ".." )
+                continue ;
+            auto child = rel.empty() ? name : rel + "/" + name;
+            if( is_dir ) {
+                list_files_recursive(base, child, out);
+            }
+            else {
+                out.push_back(::std::move(child));
+            }
+#ifdef _WIN32
+        } while( FindNextFileA(handle, &data) );
+        FindClose(handle);
+#else
+        }
+        closedir(handle);
+#endif
+    }
+}
+
+ContentHash ContentHash::for_file(const ::helpers::path& p)
+{
+    ::std::ifstream ifs(p.str(), ::std::ios::binary);
+    if( !ifs.good() ) {
+        return ContentHash::missing();
+    }
+    ContentHash rv;
+    char    buf[64*1024];
+    while( ifs.good() )
+    {
+        ifs.read(buf, sizeof(buf));
+        rv.update(buf, static_cast<size_t>(ifs.gcount()));
+    }
+    return rv;
+}
+ContentHash ContentHash::for_directory(const ::helpers::path& p)
+{
+    ::std::vector<::std::string>    files;
+    list_files_recursive(p, "", files);
+    // Directory iteration order isn't stable, so sort
+    ::std::sort(files.begin(), files.end());
+
+    ContentHash rv;
+    for(const auto& f : files)
+    {
+        auto fh = ContentHash::for_file(p / f.c_str());
+        rv.update(f.c_str());
+        rv.update(&fh.m_val, sizeof(fh.m_val));
+    }
+    return rv;
+}
+ContentHash ContentHash::for_command(const RunnableJob& job)
+{
+    ContentHash rv;
+    rv.update(job.exe_name);
+    for(const auto* a : job.args.get_vec())
+        rv.update(a);
+    rv.update("");
+    for(auto kv : job.env)
+    {
+        rv.update(kv.first);
+        rv.update(kv.second);
+    }
+    rv.update("");
+    rv.update(job.working_directory.is_valid() ? job.working_directory.str().c_str() : "");
+    return rv;
+}
+
+void ContentHash::update(const void* data, size_t len)
+{
+    const auto* p = static_cast<const uint8_t*>(data);
+    for(size_t i = 0; i < len; i ++)
+    {
+        m_val ^= p[i];
+        m_val *= 0x100000001b3ull;
+    }
+}
+void ContentHash::update(const char* s)
+{
+    update(s, ::std::strlen(s) + 1);
+}
+
+::std::ostream& operator<<(::std::ostream& os, const ContentHash& x)
+{
+    auto flags = os.flags();
+    os << ::std::hex << ::std::setw(16) << ::std::setfill('0') << x.m_val;
+    os.flags(flags);
+    return os;
+}
+::std::istream& operator>>(::std::istream& is, ContentHash& x)
+{
+    auto flags = is.flags();
+    is >> ::std::hex >> x.m_val;
+    is.flags(flags);
+    return is;
+}
+
+bool Fingerprint::load(const ::helpers::path& path)
+{
+    ::std::ifstream ifs(path.str());
+    if( !ifs.good() )
+        return false;
+
+    ::std::string   line;
+    if( !::std::getline(ifs, line) || line != "minicargo-fingerprint 1" )
+        return false;
+
+    bool has_compiler = false;
+    bool has_command = false;
+    this->inputs.clear();
+    while( ::std::getline(ifs, line) )
+    {
+        if( line.empty() )
+            continue ;
+        ::std::istringstream    ss(line);
+        ::std::string   tag;
+        ContentHash h;
+        if( !(ss >> tag >> h) )
+            return false;
+        if( tag == "compiler" ) {
+            this->compiler = h;
+            has_compiler = true;
+        }
+        else if( tag == "command" ) {
+            this->command = h;
+            has_command = true;
+        }
+        else if( tag == "input" ) {
+            // Path is the remainder of the line (can contain spaces)
+            ss.get();
+            ::std::string   p;
+            ::std::getline(ss, p);
+            if( p.empty() )
+                return false;
+            this->inputs.push_back(::std::make_pair(::std::move(p), h));
+        }
+        else {
+            return false;
+        }
+    }
+    return has_compiler && has_command;
+}
+void Fingerprint::save(const ::helpers::path& path) const
+{
+    // Write to a temporary and rename, so an interrupted build can't leave a truncated (but valid) fingerprint
+    auto tmp_path = make_temp_path(path);
+    {
+        ::std::ofstream ofs(tmp_path.str());
+        ofs << "minicargo-fingerprint 1\n";
+        ofs << "compiler " << this->compiler << "\n";
+        ofs << "command " << this->command << "\n";
+        for(const auto& i : this->inputs)
+        {
+            ofs << "input " << i.second << " " << i.first << "\n";
+        }
+        if( !ofs.good() )
+        {
+            ofs.close();
+            remove(tmp_path.str().c_str());
+            return ;
+        }
+    }
+    if( !replace_file(tmp_path, path) )
+    {
+        remove(tmp_path.str().c_str());
+    }
+}
+
+::helpers::path make_temp_path(const ::helpers::path& dst)
+{
+    static ::std::atomic<unsigned>  s_counter { 0 };
+#ifdef _WIN32
+    auto pid = GetCurrentProcessId();
+#else
+    auto pid = getpid();
+#endif
+    ::std::stringstream ss;
+    ss << "." << pid << "." << s_counter++ << ".tmp";
+    return dst + ss.str().c_str();
+}
+bool replace_file(const ::helpers::path& tmp, const ::helpers::path& dst)
+{
+#ifdef _WIN32
+    // `rename` fails if the destination exists
+    return MoveFileExA(tmp.str().c_str(), dst.str().c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    // POSIX `rename` atomically replaces the destination
+    return rename(tmp.str().c_str(), dst.str().c_str()) == 0;
+#endif
+}
@@ -0,0 +1,84 @@
+/*
+ * minicargo - MRustC-specific clone of `cargo`
+ * - By John Hodge (Mutabah)
+ *
+ * fingerprint.h
+ * - Content-hash based build fingerprints (alternative to timestamps)
+ */
+#pragma once
+
+#include <path.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+
+struct RunnableJob;
+
+/// 64-bit FNV-1a hash of some content (file contents, command lines, ...)
+class ContentHash
+{
+    uint64_t    m_val;
+
+    ContentHash(uint64_t v):
+        m_val(v)
+    {
+    }
+public:
+    ContentHash():
+        m_val(0xcbf29ce484222325ull)
+    {
+    }
+
+    /// Hash the contents of a file (returns `missing()` if the file can't be read)
+    static ContentHash for_file(const ::helpers::path& p);
+    /// Hash the names and contents of all files within a directory (recursively)
+    static ContentHash for_directory(const ::helpers::path& p);
+    /// Hash the executable, arguments, and environment of a job
+    static ContentHash for_command(const RunnableJob& job);
+    static ContentHash missing() {
+        return ContentHash { 0 };
+    }
+
+    void update(const void* data, size_t len);
+    // NOTE: Includes the terminating NUL, so that sequences of strings don't alias
+    void update(const char* s);
+    void update(const ContentHash& h) {
+        update(&h.m_val, sizeof(h.m_val));
+    }
+
+    bool operator==(const ContentHash& x) const {
+        return m_val == x.m_val;
+    }
+    bool operator!=(const ContentHash& x) const {
+        return m_val != x.m_val;
+    }
+
+    friend ::std::ostream& operator<<(::std::ostream& os, const ContentHash& x);
+    friend ::std::istream& operator>>(::std::istream& is, ContentHash& x);
+};
+
+/// Record of the inputs used to produce a file, stored alongside it as `<outfile>.fp`
+struct Fingerprint
+{
+    /// Hash of the compiler executable
+    ContentHash compiler;
+    /// Hash of the command line and environment
+    ContentHash command;
+    /// Input files (sources from the depfile, extern crates, build script executables)
+    ::std::vector< ::std::pair<::std::string, ContentHash> >  inputs;
+
+    static ::helpers::path path_for(const ::helpers::path& outfile) {
+        return outfile + ".fp";
+    }
+
+    /// Load a saved fingerprint, returns false if missing or malformed
+    bool load(const ::helpers::path& path);
+    void save(const ::helpers::path& path) const;
+};
+
+/// Temporary path next to `dst`, unique to this process and call (other minicargo instances can be writing the same
+/// destination, e.g. in a shared cache directory)
+::helpers::path make_temp_path(const ::helpers::path& dst);
+/// Move `tmp` over `dst`, replacing any existing file without `dst` ever being missing
+bool replace_file(const ::helpers::path& tmp, const ::helpers::path& dst);
@@ -157,6 +157,16 @@ bool JobList::run_all(size_t num_jobs, bool dry_run)
 
         auto job = ::std::move(this->runnable_jobs.front());
         this->runnable_jobs.pop_front();
+        if( !dry_run && job->try_complete_cached() )
+        {
+            ::std::cout << "--- ";
+            os_support::set_console_colour(::std::cout, os_support::TerminalColour::Green);
+            ::std::cout << "CACHED " << job->name();
+            os_support::set_console_colour(::std::cout, os_support::TerminalColour::Default);
+            ::std::cout << std::endl;
+            this->completed_jobs.insert(job->name());
+            continue;
+        }
         auto rjob = job->start();
         if( dry_run )
         {
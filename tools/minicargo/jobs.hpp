@@ -41,6 +41,8 @@ public:
     virtual bool is_runnable() const = 0;
     virtual RunnableJob start() = 0;
     virtual bool complete(bool was_successful) = 0;
+    /// Attempt to complete the job without running it (e.g. by restoring outputs from a cache)
+    virtual bool try_complete_cached() { return false; }
 };
 class JobList
 {
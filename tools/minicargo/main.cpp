@@ -58,6 +58,9 @@ struct ProgramOptions
     /// Enable debug output (`-g` passed)
     bool enable_debug = false;
 
+    /// Use content hashes instead of timestamps for rebuild detection
+    bool use_fingerprints = false;
+
     bool no_default_features = false;
     ::std::vector<::std::string>    features;
 
@@ -227,6 +230,7 @@ int main(int argc, const char* argv[])
         build_opts.lib_search_dirs.reserve(opts.lib_search_dirs.size());
         build_opts.emit_mmir = opts.emit_mmir;
         build_opts.enable_debug = opts.enable_debug;
+        build_opts.use_fingerprints = opts.use_fingerprints;
         build_opts.target_name = opts.target;
         for(const auto* d : opts.lib_search_dirs)
             build_opts.lib_search_dirs.push_back( ::helpers::path(d) );
@@ -407,6 +411,9 @@ int ProgramOptions::parse(int argc, const char* argv[])
             else if( ::std::strcmp(arg, "--test") == 0 ) {
                 this->test = true;
             }
+            else if( ::std::strcmp(arg, "--fingerprint") == 0 ) {
+                this->use_fingerprints = true;
+            }
             else {
                 ::std::cerr << "Unknown flag " << arg << ::std::endl;
                 return 1;
@@ -445,6 +452,7 @@ void ProgramOptions::help() const
         << "-j <count>               : Run at most <count> build tasks at once (default is to run only one)\n"
         << "-n                       : Don't build any packages, just list the packages that would be built\n"
         << "-g                       : Pass `-g` to compiler\n"
+        << "--fingerprint            : Use content hashes (instead of timestamps) to determine if a rebuild is needed\n"
         << "--no-default-features    : \n"
         << "--features <list>        : \n"
         ;
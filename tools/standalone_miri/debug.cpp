@@ -9,7 +9,7 @@
 #include <fstream>
 #include "../../src/common.hpp" // FmtEscaped
 
-unsigned DebugSink::s_indent = 0;
+thread_local unsigned DebugSink::s_indent = 0;
 ::std::unique_ptr<std::ofstream> DebugSink::s_out_file;
 
 DebugSink::DebugSink(::std::ostream& inner, bool stderr_too):
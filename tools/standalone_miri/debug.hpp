@@ -24,7 +24,8 @@ enum class DebugLevel {
 class DebugSink//:
     //public ::std::ostream
 {
-    static unsigned s_indent;
+    // Per-thread, as `backend_c` emits from multiple threads
+    static thread_local unsigned s_indent;
     static ::std::unique_ptr<std::ofstream> s_out_file;
     ::std::ostream& m_inner;
     bool m_stderr_too;
@@ -26,6 +26,11 @@ struct ProgramOptions
 
     // Output logfile
     ::std::string   logfile;
+    // Profiler output (collapsed stacks, with per-function counts in `.counts`)
+    ::std::string   profile_file;
+    unsigned    profile_interval = 1000;
+    // Number of calls before a function is checked for result caching (zero disables)
+    unsigned    memo_threshold = 0;
     // Arguments for the program
     ::std::vector<const char*>  args;
 
@@ -107,15 +112,23 @@ int main(int argc, const char* argv[])
     try
     {
         GlobalState global(tree);
-        InterpreterThread   root_thread(global);
+        ::std::unique_ptr<Profiler> profiler;
+        if( opts.profile_file != "" )
+        {
+            profiler.reset(new Profiler(opts.profile_interval));
+            global.m_profiler = profiler.get();
+        }
+        global.m_memo_threshold = opts.memo_threshold;
+        auto& root_thread = global.new_thread();
 
         ::std::vector<Value>    args;
         args.push_back(::std::move(val_argc));
         args.push_back(::std::move(val_argv));
-        Value   rv;
         root_thread.start("main#", ::std::move(args));
-        while( !root_thread.step_one(rv) )
+        Value   rv = global.run_threads();
+        if( profiler )
         {
+            profiler->write(opts.profile_file);
         }
 
         LOG_NOTICE("Return code: " << rv);
@@ -205,6 +218,27 @@ int ProgramOptions::parse(int argc, const char* argv[])
                 const char* opt = argv[++argidx];
                 this->logfile = opt;
             }
+            else if( ::std::strcmp(arg, "--profile") == 0 ) {
+                if( argidx + 1 == argc ) {
+                    ::std::cerr << "Option " << arg << " requires an argument" << ::std::endl;
+                    return 1;
+                }
+                this->profile_file = argv[++argidx];
+            }
+            else if( ::std::strcmp(arg, "--memo-threshold") == 0 ) {
+                if( argidx + 1 == argc ) {
+                    ::std::cerr << "Option " << arg << " requires an argument" << ::std::endl;
+                    return 1;
+                }
+                this->memo_threshold = ::std::strtoul(argv[++argidx], nullptr, 10);
+            }
+            else if( ::std::strcmp(arg, "--profile-interval") == 0 ) {
+                if( argidx + 1 == argc ) {
+                    ::std::cerr << "Option " << arg << " requires an argument" << ::std::endl;
+                    return 1;
+                }
+                this->profile_interval = ::std::strtoul(argv[++argidx], nullptr, 10);
+            }
             //else if( ::std::strcmp(arg, "--api") == 0 ) {
             //}
             else {
@@ -223,4 +257,8 @@ int ProgramOptions::parse(int argc, const char* argv[])
 void ProgramOptions::show_help(const char* prog) const
 {
     ::std::cout << "USAGE: " << prog << " <infile> <... args>" << ::std::endl;
+    ::std::cout << "--logfile <file>          : Write debug logging to <file>" << ::std::endl;
+    ::std::cout << "--profile <file>          : Write sampled call stacks (collapsed format) to <file>, and per-function/block counts to <file>.counts" << ::std::endl;
+    ::std::cout << "--profile-interval <n>    : Instructions between profiler samples (default 1000)" << ::std::endl;
+    ::std::cout << "--memo-threshold <n>      : Cache results of pure value-only functions after <n> calls (default 0, disabled)" << ::std::endl;
 }
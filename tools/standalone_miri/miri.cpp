@@ -12,6 +12,7 @@
 #include "string_view.hpp"
 #include <algorithm>
 #include <iomanip>
+#include <functional>
 #include "debug.hpp"
 #include "miri.hpp"
 #include <target_version.hpp>
@@ -428,7 +429,9 @@ struct MirHelpers
 };
 
 GlobalState::GlobalState(const ModuleTree& modtree):
-    m_modtree(modtree)
+    m_modtree(modtree),
+    m_profiler(nullptr),
+    m_memo_threshold(0)
 {
     // Generate statics
     m_modtree.iterate_statics([this](RcString name, const Static& s) {
@@ -441,7 +444,7 @@ GlobalState::GlobalState(const ModuleTree& modtree):
             RelocationPtr   ptr;
             if( r.fcn_path.n == "" )
             {
-                auto a = Allocation::new_alloc( r.string.size(), FMT_STRING("static " << name) );
+                auto a = Allocation::new_alloc( r.string.size(), RcString(FMT_STRING("static " << name)) );
                 a->write_bytes(0, r.string.data(), r.string.size());
                 ptr = RelocationPtr::new_alloc(::std::move(a));
             }
@@ -526,6 +529,95 @@ GlobalState::GlobalState(const ModuleTree& modtree):
 
     // No need to fudge the fds
     m_fcn_overrides.insert(::std::make_pair( "ZRG4cD8std0_0_03sys4unixB_021sanitize_standard_fds0g", cb_nop )); // 1.54
+
+    register_extern_handlers();
+    register_intrinsic_handlers();
+}
+
+GlobalState::~GlobalState()
+{
+}
+
+InterpreterThread& GlobalState::new_thread()
+{
+    unsigned thread_id = m_threads.size() + 1;
+    m_threads.push_back( ::std::unique_ptr<InterpreterThread>(new InterpreterThread(*this, thread_id)) );
+    return *m_threads.back();
+}
+InterpreterThread& GlobalState::get_thread(uint64_t thread_id)
+{
+    LOG_ASSERT(thread_id != 0 && thread_id <= m_threads.size(), "Invalid thread ID " << thread_id);
+    return *m_threads[thread_id - 1];
+}
+Value GlobalState::run_threads()
+{
+    // Number of instructions a thread runs before the next thread is given a turn
+    const unsigned TIME_SLICE = 1000;
+
+    LOG_ASSERT(!m_threads.empty(), "No threads to run");
+    size_t  idx = 0;
+    // Number of consecutive live threads that couldn't make progress
+    size_t  n_idle = 0;
+    for(;;)
+    {
+        auto& t = *m_threads[idx];
+        if( !t.m_finished )
+        {
+            bool made_progress = false;
+            for(unsigned i = 0; i < TIME_SLICE; i ++)
+            {
+                t.m_thread.blocked = false;
+                t.m_thread.timed_wait = false;
+                if( t.step_one(t.m_result) )
+                {
+                    LOG_DEBUG("Thread " << t.m_thread.thread_id << " complete");
+                    t.m_finished = true;
+                    made_progress = true;
+                    break;
+                }
+                if( t.m_thread.blocked )
+                    break;
+                made_progress = true;
+            }
+
+            // The process ends when `main` returns, regardless of other threads
+            if( idx == 0 && t.m_finished )
+            {
+                for(auto& other : m_threads)
+                    other->m_stack.clear();
+                return ::std::move(t.m_result);
+            }
+
+            if( made_progress )
+            {
+                n_idle = 0;
+            }
+            else
+            {
+                n_idle += 1;
+                size_t n_live = ::std::count_if(m_threads.begin(), m_threads.end(), [](const std::unique_ptr<InterpreterThread>& t){ return !t->m_finished; });
+                if( n_idle >= n_live )
+                {
+                    // Every thread is blocked, time out any timed waits (or error if there are none)
+                    bool any_timed = false;
+                    for(auto& other : m_threads)
+                    {
+                        if( !other->m_finished && other->m_thread.timed_wait )
+                        {
+                            other->m_thread.wait_timed_out = true;
+                            any_timed = true;
+                        }
+                    }
+                    if( !any_timed )
+                    {
+                        LOG_ERROR("Deadlock - all " << n_live << " threads are blocked");
+                    }
+                    n_idle = 0;
+                }
+            }
+        }
+        idx = (idx + 1) % m_threads.size();
+    }
 }
 
 // ====================================================================
@@ -576,6 +668,17 @@ bool InterpreterThread::step_one(Value& out_thread_result)
         LOG_ERROR("Maximum stack depth of " << MAX_STACK_DEPTH << " exceeded");
     }
 
+    if( m_global.m_profiler && m_global.m_profiler->count(*cur_frame.fcn, cur_frame.bb_idx) )
+    {
+        ::std::vector<const Function*>  frames;
+        for(const auto& f : m_stack)
+        {
+            if( !f.cb )
+                frames.push_back(f.fcn);
+        }
+        m_global.m_profiler->add_sample(frames);
+    }
+
     MirHelpers  state { *this, cur_frame };
 
     if( cur_frame.stmt_idx < bb.statements.size() )
@@ -1750,7 +1853,14 @@ bool InterpreterThread::step_one(Value& out_thread_result)
                 }
 
                 LOG_DEBUG("Call " << *fcn_p);
-                if( !this->call_path(rv, *fcn_p, ::std::move(sub_args)) )
+                bool is_immediate;
+                if( fcn_alloc_ptr )
+                    is_immediate = this->call_target(rv, *fcn_p, get_indirect_call_target(cur_frame, *fcn_p), ::std::move(sub_args));
+                else if( te.fcn.is_Path() )
+                    is_immediate = this->call_target(rv, *fcn_p, get_direct_call_target(cur_frame, *fcn_p), ::std::move(sub_args));
+                else
+                    is_immediate = this->call_path(rv, *fcn_p, ::std::move(sub_args));
+                if( !is_immediate )
                 {
                     // Early return, don't want to update stmt_idx yet
                     LOG_DEBUG("- Non-immediate return, do not advance yet");
@@ -1849,6 +1959,7 @@ InterpreterThread::StackFrame::StackFrame(const Function& fcn, ::std::vector<Val
     args( ::std::move(args) ),
     locals( ),
     drop_flags( fcn.m_mir.drop_flags ),
+    call_caches(nullptr),
     bb_idx(0),
     stmt_idx(0)
 {
@@ -1866,51 +1977,351 @@ InterpreterThread::StackFrame::StackFrame(const Function& fcn, ::std::vector<Val
         }
     }
 }
-bool InterpreterThread::call_path(Value& ret, const ::HIR::Path& path, ::std::vector<Value> args)
+const GlobalState::CallTarget& GlobalState::get_call_target(const ::HIR::Path& path)
 {
+    auto it = m_call_targets.find(path.n);
+    if( it != m_call_targets.end() )
+        return it->second;
+
+    CallTarget  rv { nullptr, nullptr, nullptr, false };
     // Support overriding certain functions
+    auto it_o = m_fcn_overrides.find(path.n);
+    if( it_o != m_fcn_overrides.end() )
     {
-        auto it = m_global.m_fcn_overrides.find(path.n);
-        if( it != m_global.m_fcn_overrides.end() )
+        rv.override_fcn = it_o->second;
+    }
+    else
+    {
+        // TODO: Support paths that reference extern functions directly (instead of needing `link_name` set)
+        //if( path.n.c_str()[0] == ':' m_name == "" && path.m_trait.m_simplepath.crate_name == "#FFI" )
+        //{
+        //    const auto& link_abi  = path.m_trait.m_simplepath.ents.at(0);
+        //    const auto& link_name = path.m_trait.m_simplepath.ents.at(1);
+        //    return this->call_extern(ret, link_name, link_abi, ::std::move(args));
+        //}
+
+        rv.fcn = &m_modtree.get_function(path);
+        if( rv.fcn->external.link_name != "" )
         {
-            return it->second(*this, ret, path, std::move(args));
+            const auto& name = rv.fcn->external.link_name;
+            const Function* ext_fcn = nullptr;
+            if(name == "__rust_allocate"
+                || name == "__rust_reallocate"
+                )
+            {
+                // Force using the `call_extern` version
+            }
+            else
+            {
+                // Search for a function with both code and this link name
+                ext_fcn = m_modtree.get_ext_function(name.c_str());
+            }
+
+            if( ext_fcn )
+            {
+                LOG_DEBUG("Matched extern - `" << name << "`");
+                rv.fcn = ext_fcn;
+            }
+            else
+            {
+                // External function!
+                rv.is_extern = true;
+                auto it_e = m_extern_handlers.find(name);
+                if( it_e != m_extern_handlers.end() )
+                {
+                    rv.extern_fcn = it_e->second;
+                }
+            }
         }
     }
+    return m_call_targets.insert(::std::make_pair(path.n, rv)).first->second;
+}
 
-    // TODO: Support paths that reference extern functions directly (instead of needing `link_name` set)
-    //if( path.n.c_str()[0] == ':' m_name == "" && path.m_trait.m_simplepath.crate_name == "#FFI" )
-    //{
-    //    const auto& link_abi  = path.m_trait.m_simplepath.ents.at(0);
-    //    const auto& link_name = path.m_trait.m_simplepath.ents.at(1);
-    //    return this->call_extern(ret, link_name, link_abi, ::std::move(args));
-    //}
+GlobalState::CallSiteCache& InterpreterThread::get_call_site_cache(StackFrame& frame)
+{
+    if( !frame.call_caches )
+    {
+        auto& caches = m_global.m_call_site_caches[frame.fcn];
+        if( caches.empty() )
+            caches.resize(frame.fcn->m_mir.blocks.size());
+        frame.call_caches = &caches;
+    }
+    return frame.call_caches->at(frame.bb_idx);
+}
+const GlobalState::CallTarget& InterpreterThread::get_direct_call_target(StackFrame& frame, const ::HIR::Path& path)
+{
+    auto& cs = get_call_site_cache(frame);
+    if( !cs.direct )
+    {
+        cs.direct = &m_global.get_call_target(path);
+    }
+    return *cs.direct;
+}
+const GlobalState::CallTarget& InterpreterThread::get_indirect_call_target(StackFrame& frame, const ::HIR::Path& path)
+{
+    auto& ic = get_call_site_cache(frame);
+    // NOTE: Copies of a function pointer share the same string, so this is almost always hit for a repeated target
+    for(unsigned i = 0; i < ic.n_used; i ++)
+    {
+        if( ic.keys[i].c_str() == path.n.c_str() )
+            return *ic.targets[i];
+    }
 
-    const auto& fcn = m_global.m_modtree.get_function(path);
+    const auto& rv = m_global.get_call_target(path);
+    // Once full, the call site is megamorphic and just uses the global lookup
+    if( ic.n_used < GlobalState::CallSiteCache::N_ENTRIES )
+    {
+        ic.keys[ic.n_used] = path.n;
+        ic.targets[ic.n_used] = &rv;
+        ic.n_used += 1;
+    }
+    return rv;
+}
 
-    if( fcn.external.link_name != "" )
+namespace {
+    // A function can have its results cached if its result depends only on its arguments
+    // - No pointers in any argument, local, or the return type (so no memory access, and no statics)
+    // - No calls, apart from pure intrinsics, diverging calls (panics), and calls to pure functions (checked by `is_pure_call`)
+    bool is_pure_function(const Function& fcn, ::std::function<bool(const ::HIR::Path&)> is_pure_call)
     {
-        const auto& name = fcn.external.link_name;
-        if(name == "__rust_allocate"
-            || name == "__rust_reallocate"
-            )
+        auto is_value_type = [](const ::HIR::TypeRef& ty) {
+            return !ty.has_pointer() && ty.inner_type != RawType::TraitObject && ty.inner_type != RawType::Str;
+        };
+        if( !is_value_type(fcn.ret_ty) )
+            return false;
+        for(const auto& ty : fcn.args)
+            if( !is_value_type(ty) )
+                return false;
+        for(const auto& ty : fcn.m_mir.locals)
+            if( !is_value_type(ty) )
+                return false;
+
+        auto check_lv = [](const ::MIR::LValue& lv) {
+            return !lv.m_root.is_Static();
+        };
+        auto check_param = [&](const ::MIR::Param& p) {
+            TU_MATCH_HDRA( (p), {)
+            TU_ARMA(LValue, e)  return check_lv(e);
+            TU_ARMA(Borrow, e)  return false;
+            TU_ARMA(Constant, e)    return true;
+            }
+            return false;
+        };
+        auto check_params = [&](const ::std::vector<::MIR::Param>& ps) {
+            return ::std::all_of(ps.begin(), ps.end(), check_param);
+        };
+        static const char* const PURE_INTRINSICS[] = {
+            "add_with_overflow", "sub_with_overflow", "mul_with_overflow",
+            "overflowing_add", "overflowing_sub", "wrapping_add", "wrapping_sub",
+            "unchecked_add", "unchecked_sub", "saturating_add", "saturating_sub",
+            "exact_div", "cttz_nonzero", "ctpop",
+            "likely", "unlikely", "assume", "transmute",
+            };
+
+        for(const auto& bb : fcn.m_mir.blocks)
         {
-            // Force using the `call_extern` version
+            for(const auto& stmt : bb.statements)
+            {
+                TU_MATCH_HDRA( (stmt), {)
+                default:
+                    // Drop (could call a destructor) and inline assembly
+                    return false;
+                TU_ARMA(SetDropFlag, se) {
+                    }
+                TU_ARMA(ScopeEnd, se) {
+                    }
+                TU_ARMA(Assign, se) {
+                    if( !check_lv(se.dst) )
+                        return false;
+                    bool ok = true;
+                    TU_MATCH_HDRA( (se.src), {)
+                    TU_ARMA(Use, re)    ok = check_lv(re);
+                    TU_ARMA(Borrow, re) ok = false;
+                    TU_ARMA(Constant, re)   ok = true;
+                    TU_ARMA(SizedArray, re) ok = check_param(re.val);
+                    TU_ARMA(Cast, re)   ok = check_lv(re.val);
+                    TU_ARMA(BinOp, re)  ok = check_param(re.val_l) && check_param(re.val_r);
+                    TU_ARMA(UniOp, re)  ok = check_lv(re.val);
+                    TU_ARMA(DstMeta, re)    ok = false;
+                    TU_ARMA(DstPtr, re) ok = false;
+                    TU_ARMA(MakeDst, re)    ok = false;
+                    TU_ARMA(Tuple, re)  ok = check_params(re.vals);
+                    TU_ARMA(Array, re)  ok = check_params(re.vals);
+                    TU_ARMA(UnionVariant, re)   ok = check_param(re.val);
+                    TU_ARMA(EnumVariant, re)    ok = check_params(re.vals);
+                    TU_ARMA(Struct, re) ok = check_params(re.vals);
+                    }
+                    if( !ok )
+                        return false;
+                    }
+                }
+            }
+
+            TU_MATCH_HDRA( (bb.terminator), {)
+            default:
+                return false;
+            TU_ARMA(Return, te) {
+                }
+            TU_ARMA(Diverge, te) {
+                // Only continues unwinding (and no result is recorded while a panic is active)
+                }
+            TU_ARMA(Goto, te) {
+                }
+            TU_ARMA(If, te) {
+                if( !check_lv(te.cond) )
+                    return false;
+                }
+            TU_ARMA(Switch, te) {
+                if( !check_lv(te.val) )
+                    return false;
+                }
+            TU_ARMA(SwitchValue, te) {
+                if( !check_lv(te.val) )
+                    return false;
+                }
+            TU_ARMA(Call, te) {
+                if( !check_lv(te.ret_val) || !check_params(te.args) )
+                    return false;
+                if( const auto* ie = te.fcn.opt_Intrinsic() )
+                {
+                    if( ::std::none_of(::std::begin(PURE_INTRINSICS), ::std::end(PURE_INTRINSICS), [&](const char* n){ return ie->name == n; }) )
+                        return false;
+                }
+                else if( te.ret_val.is_Local() && fcn.m_mir.locals.at(te.ret_val.as_Local()) == RawType::Unreachable )
+                {
+                    // Diverging calls (e.g. panics) never return, so no result is recorded for arguments that hit them
+                }
+                else if( const auto* pe = te.fcn.opt_Path() )
+                {
+                    if( !is_pure_call(*pe) )
+                        return false;
+                }
+                else
+                {
+                    // Function pointers could point anywhere
+                    return false;
+                }
+                }
+            }
         }
-        else
+        return true;
+    }
+
+    void append_value_bytes(::std::string& out, const Value& v)
+    {
+        out.append(reinterpret_cast<const char*>(v.data_ptr()), v.size());
+        out.append(reinterpret_cast<const char*>(v.get_mask()), (v.size() + 7) / 8);
+    }
+}
+
+GlobalState::FunctionMemo* GlobalState::get_memo(const Function& fcn)
+{
+    auto& memo = m_memos[&fcn];
+    if( memo.state == FunctionMemo::State::Unknown )
+    {
+        memo.call_count += 1;
+        if( memo.call_count < m_memo_threshold )
+            return nullptr;
+        ::std::vector<FunctionMemo*>    decided;
+        if( !check_pure(fcn, decided) )
+        {
+            // Callees were checked assuming that this function (and anything else in progress) was pure, so re-check them later
+            for(auto* m : decided)
+                m->state = FunctionMemo::State::Unknown;
+        }
+        LOG_DEBUG(fcn.my_path << " is " << (memo.state == FunctionMemo::State::Pure ? "pure" : "impure"));
+    }
+    return memo.state == FunctionMemo::State::Pure ? &memo : nullptr;
+}
+bool GlobalState::check_pure(const Function& fcn, ::std::vector<FunctionMemo*>& decided)
+{
+    auto& memo = m_memos[&fcn];
+    switch(memo.state)
+    {
+    case FunctionMemo::State::Unknown:
+        break;
+    case FunctionMemo::State::Checking:
+        // Recursive call, assume pure (if it isn't, the outermost check fails)
+        return true;
+    case FunctionMemo::State::Pure:
+        return true;
+    case FunctionMemo::State::Impure:
+        return false;
+    }
+
+    memo.state = FunctionMemo::State::Checking;
+    bool rv = is_pure_function(fcn, [&](const ::HIR::Path& p) {
+        if( !m_modtree.get_function_opt(p) )
+            return false;
+        const auto& tgt = get_call_target(p);
+        if( tgt.override_fcn || tgt.is_extern || !tgt.fcn )
+            return false;
+        return check_pure(*tgt.fcn, decided);
+        });
+    memo.state = rv ? FunctionMemo::State::Pure : FunctionMemo::State::Impure;
+    if( rv )
+        decided.push_back(&memo);
+    return rv;
+}
+
+bool InterpreterThread::call_path(Value& ret, const ::HIR::Path& path, ::std::vector<Value> args)
+{
+    return this->call_target(ret, path, m_global.get_call_target(path), ::std::move(args));
+}
+bool InterpreterThread::call_target(Value& ret, const ::HIR::Path& path, const GlobalState::CallTarget& tgt, ::std::vector<Value> args)
+{
+    if( tgt.override_fcn )
+    {
+        return tgt.override_fcn(*this, ret, path, std::move(args));
+    }
+    if( tgt.is_extern )
+    {
+        const auto& link_name = tgt.fcn->external.link_name;
+        if( tgt.extern_fcn )
+        {
+            return tgt.extern_fcn(*this, ret, link_name, std::move(args));
+        }
+        return this->call_extern(ret, link_name, tgt.fcn->external.link_abi, ::std::move(args));
+    }
+
+    // Not applied directly under another wrapper frame, as `pop_stack` only handles one wrapper per return
+    if( m_global.m_memo_threshold > 0 && !(!this->m_stack.empty() && this->m_stack.back().cb) )
+    {
+        if( auto* memo = m_global.get_memo(*tgt.fcn) )
         {
-            // Search for a function with both code and this link name
-            if(const auto* ext_fcn = m_global.m_modtree.get_ext_function(name.c_str()))
+            // Limit on the number of cached results for a single function
+            const size_t MAX_MEMO_RESULTS = 1 << 16;
+
+            ::std::string   key;
+            for(const auto& a : args)
+                append_value_bytes(key, a);
+            auto it = memo->results.find(key);
+            if( it != memo->results.end() )
             {
-                LOG_DEBUG("Matched extern - `" << name << "`");
-                this->m_stack.push_back(StackFrame(*ext_fcn, ::std::move(args)));
-                return false;
+                ret = Value(tgt.fcn->ret_ty);
+                auto size = ret.size();
+                ::std::memcpy(ret.data_ptr(), it->second.data(), size);
+                ::std::memcpy(ret.get_mask_mut(), it->second.data() + size, (size + 7) / 8);
+                return true;
+            }
+            if( memo->results.size() < MAX_MEMO_RESULTS )
+            {
+                // Record the result once the function returns (unless it panicked)
+                this->m_stack.push_back(StackFrame::make_wrapper([this,memo,key](Value& out_rv, Value rv)->bool {
+                    if( !m_thread.panic_active )
+                    {
+                        ::std::string   res;
+                        append_value_bytes(res, rv);
+                        memo->results.insert(::std::make_pair(key, ::std::move(res)));
+                    }
+                    out_rv = ::std::move(rv);
+                    return true;
+                    }));
             }
         }
-        // External function!
-        return this->call_extern(ret, name, fcn.external.link_abi, ::std::move(args));
     }
 
-    this->m_stack.push_back(StackFrame(fcn, ::std::move(args)));
+    this->m_stack.push_back(StackFrame(*tgt.fcn, ::std::move(args)));
     return false;
 }
 
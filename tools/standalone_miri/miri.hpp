@@ -8,6 +8,8 @@
 #pragma once
 #include "module_tree.hpp"
 #include "value.hpp"
+#include "profiler.hpp"
+#include <unordered_map>
 
 struct ThreadState
 {
@@ -19,10 +21,32 @@ struct ThreadState
     bool    panic_active;
     Value   panic_value;
 
-    ThreadState():
+    // Interpreter thread ID (starting at 1, used as the `pthread_t` value)
+    unsigned    thread_id;
+    // Set when a call can't complete until another thread runs (e.g. `pthread_mutex_lock` on a held mutex)
+    // - The call is re-tried the next time this thread is scheduled
+    bool    blocked;
+    // Set along with `blocked` if the wait has a timeout
+    bool    timed_wait;
+    // Set by the scheduler if all threads are blocked (timed waits then return a timeout)
+    bool    wait_timed_out;
+    // State of an in-progress `pthread_cond_wait`
+    struct {
+        bool    active;
+        bool    woken;
+        bool    timed_out;
+        uint32_t    seq;
+    } cond_wait;
+
+    ThreadState(unsigned thread_id):
         call_stack_depth(0)
         ,panic_count(0)
         ,panic_active(false)
+        ,thread_id(thread_id)
+        ,blocked(false)
+        ,timed_wait(false)
+        ,wait_timed_out(false)
+        ,cond_wait({ false, false, false, 0 })
     {
     }
 
@@ -41,19 +65,94 @@ class InterpreterThread;
 struct GlobalState
 {
     typedef bool    override_handler_t(InterpreterThread& thread, Value& ret, const ::HIR::Path& path, ::std::vector<Value> args);
+    typedef bool    extern_handler_t(InterpreterThread& thread, Value& ret, const ::std::string& link_name, ::std::vector<Value> args);
+    typedef bool    intrinsic_handler_t(InterpreterThread& thread, Value& ret, const ::HIR::TypeRef& ret_ty, const RcString& name, const ::HIR::PathParams& pp, ::std::vector<Value> args);
+
+    // Resolved target of a call to a path (populated on the first call)
+    struct CallTarget
+    {
+        override_handler_t* override_fcn;
+        extern_handler_t*   extern_fcn;
+        // Function to push (or the extern declaration, if `is_extern` is set)
+        const Function* fcn;
+        bool    is_extern;
+    };
 
     const ModuleTree& m_modtree;
 
     std::map<const Static*, Value>  m_statics;
 
     std::map<RcString, override_handler_t*>  m_fcn_overrides;
+    // Externs with a dedicated handler, anything else goes through `InterpreterThread::call_extern`
+    std::unordered_map<std::string, extern_handler_t*>  m_extern_handlers;
+    // Intrinsics with a dedicated handler, anything else goes through `InterpreterThread::call_intrinsic`
+    std::unordered_map<RcString, intrinsic_handler_t*>  m_intrinsic_handlers;
+    // NOTE: Node-based, so references to entries stay valid (they're cached by call sites)
+    std::unordered_map<RcString, CallTarget>  m_call_targets;
+
+    // Cache of resolved targets for a call site (the terminator of a block)
+    struct CallSiteCache
+    {
+        // Target of a direct call (the path is fixed, so it's resolved once)
+        const CallTarget*   direct = nullptr;
+
+        // Inline cache for an indirect call (e.g. a vtable call), keyed by the identity of the called path's string
+        static const unsigned N_ENTRIES = 4;
+        unsigned    n_used = 0;
+        RcString    keys[N_ENTRIES];
+        const CallTarget*   targets[N_ENTRIES];
+    };
+    // Call site caches for each function, indexed by block
+    std::unordered_map<const Function*, std::vector<CallSiteCache>> m_call_site_caches;
+
+    // Optional execution profiler (`--profile`)
+    Profiler*   m_profiler;
+
+    // Result cache for hot functions that only operate on (pointer-free) values
+    struct FunctionMemo
+    {
+        enum class State {
+            Unknown,
+            Checking,
+            Pure,
+            Impure,
+        };
+        uint64_t    call_count = 0;
+        State   state = State::Unknown;
+        // Key is the argument bytes and masks, value is the return value's bytes and mask
+        std::unordered_map<std::string, std::string>    results;
+    };
+    // Number of calls before a function is checked for memoisation (`--memo-threshold`, zero to disable)
+    unsigned    m_memo_threshold;
+    std::unordered_map<const Function*, FunctionMemo>   m_memos;
+
+    // All interpreter threads (indexed by thread ID minus one), these are co-operatively scheduled by `run_threads`
+    std::vector<std::unique_ptr<InterpreterThread>> m_threads;
 
     GlobalState(const ModuleTree& modtree);
+    ~GlobalState();
+
+    const CallTarget& get_call_target(const ::HIR::Path& path);
+    // Returns the memoisation cache for a function, if it is hot and pure
+    FunctionMemo* get_memo(const Function& fcn);
+    // Check (and record) if a function and all functions it calls are pure, `decided` collects the functions found to be pure
+    bool check_pure(const Function& fcn, std::vector<FunctionMemo*>& decided);
+
+    InterpreterThread& new_thread();
+    InterpreterThread& get_thread(uint64_t thread_id);
+    // Run all threads until the first thread (`main`) returns, and return its result
+    Value run_threads();
+private:
+    // Defined in miri_extern.cpp
+    void register_extern_handlers();
+    // Defined in miri_intrinsic.cpp
+    void register_intrinsic_handlers();
 };
 
 class InterpreterThread
 {
     friend struct MirHelpers;
+    friend struct GlobalState;
 
     struct StackFrame
     {
@@ -66,6 +165,8 @@ class InterpreterThread
         ::std::vector<Value>    args;
         ::std::vector<Value>    locals;
         ::std::vector<bool>     drop_flags;
+        // Call site caches for this function (looked up on first call)
+        ::std::vector<GlobalState::CallSiteCache>*  call_caches;
 
         unsigned    bb_idx;
         unsigned    stmt_idx;
@@ -84,10 +185,15 @@ class InterpreterThread
     size_t  m_instruction_count;
     ::std::vector<StackFrame>   m_stack;
 
+    bool    m_finished;
+    Value   m_result;
+
 public:
-    InterpreterThread(GlobalState& m_global):
+    InterpreterThread(GlobalState& m_global, unsigned thread_id):
         m_global(m_global),
-        m_instruction_count(0)
+        m_thread(thread_id),
+        m_instruction_count(0),
+        m_finished(false)
     {
     }
     ~InterpreterThread();
@@ -101,6 +207,10 @@ private:
 
     // Returns true if the call was resolved instantly
     bool call_path(Value& ret_val, const HIR::Path& p, ::std::vector<Value> args);
+    bool call_target(Value& ret_val, const HIR::Path& p, const GlobalState::CallTarget& tgt, ::std::vector<Value> args);
+    GlobalState::CallSiteCache& get_call_site_cache(StackFrame& frame);
+    const GlobalState::CallTarget& get_direct_call_target(StackFrame& frame, const HIR::Path& p);
+    const GlobalState::CallTarget& get_indirect_call_target(StackFrame& frame, const HIR::Path& p);
     // Returns true if the call was resolved instantly
     bool call_extern(Value& ret_val, const ::std::string& name, const ::std::string& abi, ::std::vector<Value> args);
     // Returns true if the call was resolved instantly
@@ -160,9 +160,49 @@ namespace FfiHelpers {
     return output.str();
 }
 
-bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, const ::std::string& abi, ::std::vector<Value> args)
-{
-    if( link_name == "__rust_allocate" || link_name == "__rust_alloc" || link_name == "__rust_alloc_zeroed" )
+namespace {
+    // Emulated synchronisation primitives keep their state in the first words of the native object (which is all
+    // zero for the static initialisers)
+    struct SyncObject
+    {
+        ValueRef    vr;
+        SyncObject(Value& ptr, size_t size):
+            vr( ptr.read_pointer_valref_mut(0, size) )
+        {
+            LOG_ASSERT(vr.m_alloc.is_alloc(), "Synchronisation object not in an allocation - " << vr);
+        }
+        uint32_t get(unsigned idx) const {
+            return vr.read_u32(idx * 4);
+        }
+        void set(unsigned idx, uint32_t v) {
+            vr.m_alloc.alloc().write_u32(vr.m_offset + idx * 4, v);
+        }
+    };
+
+    // - mutex: Word 0 is the owning thread, word 1 is the recursion count
+    // Returns false if the mutex is held by another thread
+    bool mutex_try_lock(const ThreadState& ts, SyncObject& mutex)
+    {
+        auto owner = mutex.get(0);
+        if( owner != 0 && owner != ts.thread_id )
+            return false;
+        mutex.set(0, ts.thread_id);
+        mutex.set(1, owner == 0 ? 1 : mutex.get(1) + 1);
+        return true;
+    }
+    void mutex_unlock(const ThreadState& ts, SyncObject& mutex)
+    {
+        LOG_ASSERT(mutex.get(0) == ts.thread_id, "Unlocking a mutex not held by this thread (owner " << mutex.get(0) << ", this " << ts.thread_id << ")");
+        auto count = mutex.get(1) - 1;
+        mutex.set(1, count);
+        if( count == 0 )
+            mutex.set(0, 0);
+    }
+}
+
+// Frequently-called externs, dispatched by name via `GlobalState::m_extern_handlers` (resolved once per call target)
+namespace {
+    bool extern_rust_alloc(InterpreterThread& thread, Value& rv, const ::std::string& link_name, ::std::vector<Value> args)
     {
         static unsigned s_alloc_count = 0;
 
@@ -176,7 +216,7 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
 
         // TODO: Use the alignment when making an allocation?
         // - Could offset the returned pointer by the alignment (to catch misalign errors?)
-        auto alloc = Allocation::new_alloc(size, ::std::move(alloc_name));
+        auto alloc = Allocation::new_alloc(size, RcString(alloc_name));
         LOG_TRACE("- alloc=" << alloc << " (" << alloc->size() << " bytes)");
         auto rty = ::HIR::TypeRef(RawType::Unit).wrap( TypeWrapper::Ty::Pointer, 0 );
 
@@ -186,8 +226,9 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         }
 
         rv = Value::new_pointer_ofs(rty, 0, RelocationPtr::new_alloc(::std::move(alloc)));
+        return true;
     }
-    else if( link_name == "__rust_reallocate" || link_name == "__rust_realloc" )
+    bool extern_rust_realloc(InterpreterThread& thread, Value& rv, const ::std::string& link_name, ::std::vector<Value> args)
     {
         auto oldsize = args.at(1).read_usize(0);
         auto ptr = args.at(0).read_pointer_valref_mut(0, oldsize);
@@ -211,8 +252,9 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         alloc.resize(newsize);
 
         rv = ::std::move(args.at(0));
+        return true;
     }
-    else if( link_name == "__rust_deallocate" || link_name == "__rust_dealloc" )
+    bool extern_rust_dealloc(InterpreterThread& thread, Value& rv, const ::std::string& link_name, ::std::vector<Value> args)
     {
         auto ptr = args.at(0).read_pointer_valref_mut(0, 0);
         LOG_ASSERT(ptr.m_offset == 0, "__rust_deallocate with offset pointer");
@@ -224,8 +266,135 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         alloc.mark_as_freed();
         // Just let it drop.
         rv = Value();
+        return true;
+    }
+    bool extern_memcmp(InterpreterThread& thread, Value& rv, const ::std::string& link_name, ::std::vector<Value> args)
+    {
+        auto n = args.at(2).read_usize(0);
+        int rv_i;
+        if( n > 0 )
+        {
+            const void* ptr_b = args.at(1).read_pointer_const(0, n);
+            const void* ptr_a = args.at(0).read_pointer_const(0, n);
+
+            rv_i = memcmp(ptr_a, ptr_b, n);
+        }
+        else
+        {
+            rv_i = 0;
+        }
+        rv = Value::new_i32(rv_i);
+        return true;
+    }
+    bool extern_memset(InterpreterThread& thread, Value& rv, const ::std::string& link_name, ::std::vector<Value> args)
+    {
+        auto b = args.at(1).read_u8(0);
+        auto n = args.at(2).read_usize(0);
+        if( n > 0 )
+        {
+            auto vr = args.at(0).read_pointer_valref_mut(0, n).to_write();
+            memset(vr.data_ptr_mut(n), b, n);
+            vr.mark_bytes_valid(0, n);
+        }
+        rv = std::move(args.at(0));
+        return true;
+    }
+    bool extern_memcpy(InterpreterThread& thread, Value& rv, const ::std::string& link_name, ::std::vector<Value> args)
+    {
+        auto n = args.at(2).read_usize(0);
+        if( n > 0 )
+        {
+            auto vr_dst = args.at(0).read_pointer_valref_mut(0, n).to_write();
+            // NOTE: the `mut` part doesn't actually get checked until a write is attempted
+            auto vr_src = args.at(1).read_pointer_valref_mut(0, n);
+            vr_dst.write_value(0, vr_src.read_value(0, n));
+        }
+        rv = std::move(args.at(0));
+        return true;
+    }
+    bool extern_memchr(InterpreterThread& thread, Value& rv, const ::std::string& link_name, ::std::vector<Value> args)
+    {
+        auto ptr_alloc = args.at(0).get_relocation(0);
+        auto c = args.at(1).read_i32(0);
+        auto n = args.at(2).read_usize(0);
+        const void* ptr = args.at(0).read_pointer_const(0, n);
+
+        const void* ret = memchr(ptr, c, n);
+
+        rv = Value(::HIR::TypeRef(RawType::USize));
+        if( ret )
+        {
+            auto rv_ofs = args.at(0).read_usize(0) + ( static_cast<const uint8_t*>(ret) - static_cast<const uint8_t*>(ptr) );
+            rv.write_ptr(0, rv_ofs, ptr_alloc);
+        }
+        else
+        {
+            rv.write_usize(0, 0);
+        }
+        return true;
+    }
+    bool extern_memrchr(InterpreterThread& thread, Value& rv, const ::std::string& link_name, ::std::vector<Value> args)
+    {
+        auto ptr_alloc = args.at(0).get_relocation(0);
+        auto c = args.at(1).read_i32(0);
+        auto n = args.at(2).read_usize(0);
+        const void* ptr = args.at(0).read_pointer_const(0, n);
+
+        const void* ret = memrchr(ptr, c, n);
+
+        rv = Value(::HIR::TypeRef(RawType::USize));
+        if( ret )
+        {
+            auto rv_ofs = args.at(0).read_usize(0) + ( static_cast<const uint8_t*>(ret) - static_cast<const uint8_t*>(ptr) );
+            rv.write_ptr(0, rv_ofs, ptr_alloc);
+        }
+        else
+        {
+            rv.write_usize(0, 0);
+        }
+        return true;
     }
-    else if( link_name == "__rust_maybe_catch_panic" )
+    bool extern_strlen(InterpreterThread& thread, Value& rv, const ::std::string& link_name, ::std::vector<Value> args)
+    {
+        // strlen - custom implementation to ensure validity
+        size_t len = 0;
+        FfiHelpers::read_cstr(args.at(0), 0, &len);
+
+        //rv = Value::new_usize(len);
+        rv = Value(::HIR::TypeRef(RawType::USize));
+        rv.write_usize(0, len);
+        return true;
+    }
+}
+
+void GlobalState::register_extern_handlers()
+{
+    m_extern_handlers.insert(::std::make_pair( "__rust_allocate", &extern_rust_alloc ));
+    m_extern_handlers.insert(::std::make_pair( "__rust_alloc", &extern_rust_alloc ));
+    m_extern_handlers.insert(::std::make_pair( "__rust_alloc_zeroed", &extern_rust_alloc ));
+    m_extern_handlers.insert(::std::make_pair( "__rust_reallocate", &extern_rust_realloc ));
+    m_extern_handlers.insert(::std::make_pair( "__rust_realloc", &extern_rust_realloc ));
+    m_extern_handlers.insert(::std::make_pair( "__rust_deallocate", &extern_rust_dealloc ));
+    m_extern_handlers.insert(::std::make_pair( "__rust_dealloc", &extern_rust_dealloc ));
+    m_extern_handlers.insert(::std::make_pair( "memcmp", &extern_memcmp ));
+    m_extern_handlers.insert(::std::make_pair( "memset", &extern_memset ));
+    m_extern_handlers.insert(::std::make_pair( "memcpy", &extern_memcpy ));
+    m_extern_handlers.insert(::std::make_pair( "memchr", &extern_memchr ));
+    m_extern_handlers.insert(::std::make_pair( "memrchr", &extern_memrchr ));
+    m_extern_handlers.insert(::std::make_pair( "strlen", &extern_strlen ));
+}
+
+bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, const ::std::string& abi, ::std::vector<Value> args)
+{
+    {
+        auto it = m_global.m_extern_handlers.find(link_name);
+        if( it != m_global.m_extern_handlers.end() )
+        {
+            return it->second(*this, rv, link_name, ::std::move(args));
+        }
+    }
+
+    if( link_name == "__rust_maybe_catch_panic" )
     {
         auto fcn_path = args.at(0).read_pointer_fcn(0);
         auto& arg = args.at(1);
@@ -628,24 +797,96 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
     // >>> pthread
     else if( link_name == "pthread_self" )
     {
+        rv = Value::new_usize(m_thread.thread_id);
+    }
+    else if( link_name == "pthread_mutex_init" )
+    {
+        SyncObject  mutex(args.at(0), sizeof(pthread_mutex_t));
+        mutex.set(0, 0);
+        mutex.set(1, 0);
         rv = Value::new_i32(0);
     }
-    else if( link_name == "pthread_mutex_init"
-        || link_name == "pthread_mutex_lock"
-        || link_name == "pthread_mutex_trylock"
-        || link_name == "pthread_mutex_unlock"
-        || link_name == "pthread_mutex_destroy"
-        )
+    else if( link_name == "pthread_mutex_lock" )
     {
+        SyncObject  mutex(args.at(0), sizeof(pthread_mutex_t));
+        if( !mutex_try_lock(m_thread, mutex) )
+        {
+            m_thread.blocked = true;
+            return false;
+        }
         rv = Value::new_i32(0);
     }
-    else if( link_name == "pthread_rwlock_rdlock" )
+    else if( link_name == "pthread_mutex_trylock" )
+    {
+        SyncObject  mutex(args.at(0), sizeof(pthread_mutex_t));
+        rv = Value::new_i32( mutex_try_lock(m_thread, mutex) ? 0 : EBUSY );
+    }
+    else if( link_name == "pthread_mutex_unlock" )
     {
+        SyncObject  mutex(args.at(0), sizeof(pthread_mutex_t));
+        mutex_unlock(m_thread, mutex);
+        rv = Value::new_i32(0);
+    }
+    else if( link_name == "pthread_mutex_destroy" )
+    {
+        rv = Value::new_i32(0);
+    }
+    // - rwlock: Word 0 is the writer, word 1 is the reader count
+    else if( link_name == "pthread_rwlock_init" )
+    {
+        SyncObject  lock(args.at(0), sizeof(pthread_rwlock_t));
+        lock.set(0, 0);
+        lock.set(1, 0);
+        rv = Value::new_i32(0);
+    }
+    else if( link_name == "pthread_rwlock_rdlock" || link_name == "pthread_rwlock_tryrdlock" )
+    {
+        SyncObject  lock(args.at(0), sizeof(pthread_rwlock_t));
+        auto writer = lock.get(0);
+        if( writer != 0 && writer != m_thread.thread_id )
+        {
+            if( link_name == "pthread_rwlock_tryrdlock" ) {
+                rv = Value::new_i32(EBUSY);
+                return true;
+            }
+            m_thread.blocked = true;
+            return false;
+        }
+        lock.set(1, lock.get(1) + 1);
+        rv = Value::new_i32(0);
+    }
+    else if( link_name == "pthread_rwlock_wrlock" || link_name == "pthread_rwlock_trywrlock" )
+    {
+        SyncObject  lock(args.at(0), sizeof(pthread_rwlock_t));
+        if( lock.get(0) != 0 || lock.get(1) != 0 )
+        {
+            if( link_name == "pthread_rwlock_trywrlock" ) {
+                rv = Value::new_i32(EBUSY);
+                return true;
+            }
+            m_thread.blocked = true;
+            return false;
+        }
+        lock.set(0, m_thread.thread_id);
         rv = Value::new_i32(0);
     }
     else if( link_name == "pthread_rwlock_unlock" )
     {
-        // TODO: Check that this thread holds the lock?
+        SyncObject  lock(args.at(0), sizeof(pthread_rwlock_t));
+        if( lock.get(0) == m_thread.thread_id )
+        {
+            lock.set(0, 0);
+        }
+        else
+        {
+            // TODO: Check that this thread holds the lock?
+            LOG_ASSERT(lock.get(1) > 0, "pthread_rwlock_unlock on an unlocked rwlock");
+            lock.set(1, lock.get(1) - 1);
+        }
+        rv = Value::new_i32(0);
+    }
+    else if( link_name == "pthread_rwlock_destroy" )
+    {
         rv = Value::new_i32(0);
     }
     else if( link_name == "pthread_mutexattr_init" || link_name == "pthread_mutexattr_settype" || link_name == "pthread_mutexattr_destroy" )
@@ -695,50 +936,94 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
     //}
     else if( link_name == "pthread_create" )
     {
-        auto thread_handle_out = args.at(0).read_pointer_valref_mut(0, sizeof(pthread_t));
-        auto attrs = args.at(1).read_pointer_const(0, sizeof(pthread_attr_t));
+        auto thread_handle_out = args.at(0).read_pointer_valref_mut(0, POINTER_SIZE);
         auto fcn_path = args.at(2).read_pointer_fcn(0);
         auto& arg = args.at(3);
-        LOG_NOTICE("TODO: pthread_create(" << thread_handle_out << ", " << attrs << ", " << fcn_path << ", " << arg << ")");
-        // TODO: Create a new interpreter context with this thread, use co-operative scheduling
-        // HACK: Just run inline
-        if( true )
-        {
-            auto tls = ::std::move(m_thread.tls_values);
-            this->m_stack.push_back(StackFrame::make_wrapper([=](Value& out_rv, Value /*rv*/)mutable ->bool {
-                out_rv = Value::new_i32(0);
-                m_thread.tls_values = ::std::move(tls);
-                return true;
-                }));
+        LOG_DEBUG("pthread_create(" << thread_handle_out << ", " << fcn_path << ", " << arg << ")");
+        LOG_ASSERT(thread_handle_out.m_alloc.is_alloc(), "pthread_create with non-allocation handle pointer");
 
-            // TODO: Catch the panic out of this.
-            ::std::vector<Value>    args;
-            args.push_back(std::move(arg));
-            if( this->call_path(rv, fcn_path, std::move(args)) )
-            {
-                bool v = this->pop_stack(rv);
-                assert( v == false );
-                return true;
-            }
-            else
-            {
-                return false;
-            }
+        auto& new_thread = m_global.new_thread();
+        ::std::vector<Value>    thread_args;
+        thread_args.push_back(std::move(arg));
+        new_thread.start(fcn_path.n, ::std::move(thread_args));
+
+        thread_handle_out.m_alloc.alloc().write_usize(thread_handle_out.m_offset, new_thread.m_thread.thread_id);
+        rv = Value::new_i32(0);
+    }
+    else if( link_name == "pthread_join" )
+    {
+        auto& other = m_global.get_thread( args.at(0).read_usize(0) );
+        if( !other.m_finished )
+        {
+            m_thread.blocked = true;
+            return false;
         }
-        else {
-            //this->m_parent.create_thread(fcn_path, arg);
-            rv = Value::new_i32(EPERM);
+        if( args.at(1).read_usize(0) != 0 )
+        {
+            auto out_ptr = args.at(1).read_pointer_valref_mut(0, POINTER_SIZE);
+            LOG_ASSERT(out_ptr.m_alloc.is_alloc(), "pthread_join with non-allocation result pointer");
+            out_ptr.m_alloc.alloc().write_value(out_ptr.m_offset, ::std::move(other.m_result));
         }
+        rv = Value::new_i32(0);
     }
     else if( link_name == "pthread_detach" )
     {
         // "detach" - Prevent the need to explitly join a thread
         rv = Value::new_i32(0);
     }
-    else if( link_name == "pthread_cond_init" || link_name == "pthread_cond_destroy" )
+    // - condvar: Word 0 is a sequence number, incremented on each signal
+    // NOTE: `signal` wakes all waiters (allowed, as waits can spuriously wake)
+    else if( link_name == "pthread_cond_init" )
+    {
+        SyncObject  cond(args.at(0), sizeof(pthread_cond_t));
+        cond.set(0, 0);
+        rv = Value::new_i32(0);
+    }
+    else if( link_name == "pthread_cond_destroy" )
     {
         rv = Value::new_i32(0);
     }
+    else if( link_name == "pthread_cond_signal" || link_name == "pthread_cond_broadcast" )
+    {
+        SyncObject  cond(args.at(0), sizeof(pthread_cond_t));
+        cond.set(0, cond.get(0) + 1);
+        rv = Value::new_i32(0);
+    }
+    else if( link_name == "pthread_cond_wait" || link_name == "pthread_cond_timedwait" )
+    {
+        bool is_timed = (link_name == "pthread_cond_timedwait");
+        SyncObject  cond(args.at(0), sizeof(pthread_cond_t));
+        SyncObject  mutex(args.at(1), sizeof(pthread_mutex_t));
+        auto& cw = m_thread.cond_wait;
+        if( !cw.active )
+        {
+            cw.active = true;
+            cw.woken = false;
+            cw.timed_out = false;
+            cw.seq = cond.get(0);
+            mutex_unlock(m_thread, mutex);
+        }
+        if( !cw.woken )
+        {
+            if( cond.get(0) != cw.seq ) {
+                cw.woken = true;
+            }
+            else if( is_timed && m_thread.wait_timed_out ) {
+                cw.woken = true;
+                cw.timed_out = true;
+            }
+        }
+        // Once woken, the mutex has to be re-acquired before returning
+        if( !cw.woken || !mutex_try_lock(m_thread, mutex) )
+        {
+            m_thread.blocked = true;
+            m_thread.timed_wait = is_timed && !cw.woken;
+            return false;
+        }
+        rv = Value::new_i32(cw.timed_out ? ETIMEDOUT : 0);
+        cw.active = false;
+        m_thread.wait_timed_out = false;
+    }
     else if( link_name == "pthread_key_create" )
     {
         auto key_ref = args.at(0).read_pointer_valref_mut(0, 4);
@@ -958,89 +1243,8 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
     }
     //
     // <string.h>
+    // - memcmp/memset/memcpy/memchr/memrchr/strlen are in `m_extern_handlers`
     //
-    else if( link_name == "memcmp" )
-    {
-        auto n = args.at(2).read_usize(0);
-        int rv_i;
-        if( n > 0 )
-        {
-            const void* ptr_b = args.at(1).read_pointer_const(0, n);
-            const void* ptr_a = args.at(0).read_pointer_const(0, n);
-
-            rv_i = memcmp(ptr_a, ptr_b, n);
-        }
-        else
-        {
-            rv_i = 0;
-        }
-        rv = Value::new_i32(rv_i);
-    }
-    else if( link_name == "memset" )
-    {
-        auto b = args.at(1).read_u8(0);
-        auto n = args.at(2).read_usize(0);
-        if( n > 0 )
-        {
-            auto vr = args.at(0).read_pointer_valref_mut(0, n).to_write();
-            memset(vr.data_ptr_mut(n), b, n);
-            vr.mark_bytes_valid(0, n);
-        }
-        rv = std::move(args.at(0));
-    }
-    else if( link_name == "memcpy" )
-    {
-        auto n = args.at(2).read_usize(0);
-        if( n > 0 )
-        {
-            auto vr_dst = args.at(0).read_pointer_valref_mut(0, n).to_write();
-            // NOTE: the `mut` part doesn't actually get checked until a write is attempted
-            auto vr_src = args.at(1).read_pointer_valref_mut(0, n);
-            vr_dst.write_value(0, vr_src.read_value(0, n));
-        }
-        rv = std::move(args.at(0));
-    }
-    // - `void *memchr(const void *s, int c, size_t n);`
-    else if( link_name == "memchr" )
-    {
-        auto ptr_alloc = args.at(0).get_relocation(0);
-        auto c = args.at(1).read_i32(0);
-        auto n = args.at(2).read_usize(0);
-        const void* ptr = args.at(0).read_pointer_const(0, n);
-
-        const void* ret = memchr(ptr, c, n);
-
-        rv = Value(::HIR::TypeRef(RawType::USize));
-        if( ret )
-        {
-            auto rv_ofs = args.at(0).read_usize(0) + ( static_cast<const uint8_t*>(ret) - static_cast<const uint8_t*>(ptr) );
-            rv.write_ptr(0, rv_ofs, ptr_alloc);
-        }
-        else
-        {
-            rv.write_usize(0, 0);
-        }
-    }
-    else if( link_name == "memrchr" )
-    {
-        auto ptr_alloc = args.at(0).get_relocation(0);
-        auto c = args.at(1).read_i32(0);
-        auto n = args.at(2).read_usize(0);
-        const void* ptr = args.at(0).read_pointer_const(0, n);
-
-        const void* ret = memrchr(ptr, c, n);
-
-        rv = Value(::HIR::TypeRef(RawType::USize));
-        if( ret )
-        {
-            auto rv_ofs = args.at(0).read_usize(0) + ( static_cast<const uint8_t*>(ret) - static_cast<const uint8_t*>(ptr) );
-            rv.write_ptr(0, rv_ofs, ptr_alloc);
-        }
-        else
-        {
-            rv.write_usize(0, 0);
-        }
-    }
     else if( link_name == "strcpy" ) {
         // strlen - custom implementation to ensure validity
         size_t len = 0;
@@ -1051,16 +1255,6 @@ bool InterpreterThread::call_extern(Value& rv, const ::std::string& link_name, c
         vr.mark_bytes_valid(0, len+1);
         rv = std::move(args.at(0));
     }
-    else if( link_name == "strlen" )
-    {
-        // strlen - custom implementation to ensure validity
-        size_t len = 0;
-        FfiHelpers::read_cstr(args.at(0), 0, &len);
-
-        //rv = Value::new_usize(len);
-        rv = Value(::HIR::TypeRef(RawType::USize));
-        rv.write_usize(0, len);
-    }
     else if( link_name == "strcmp" )
     {
         size_t len;
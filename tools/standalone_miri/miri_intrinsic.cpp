@@ -17,84 +17,14 @@
 #include <target_version.hpp>
 #include "primitive_value.h"
 
-bool InterpreterThread::call_intrinsic(Value& rv, const HIR::TypeRef& ret_ty, const RcString& name, const ::HIR::PathParams& ty_params, ::std::vector<Value> args)
-{
-    TRACE_FUNCTION_R(name, rv);
-    for(const auto& a : args)
-        LOG_DEBUG("#" << (&a - args.data()) << ": " << a);
-    if( name == "type_id" )
-    {
-        const auto& ty_T = ty_params.tys.at(0);
-        static ::std::vector<HIR::TypeRef>  type_ids;
-        auto it = ::std::find(type_ids.begin(), type_ids.end(), ty_T);
-        if( it == type_ids.end() )
-        {
-            it = type_ids.insert(it, ty_T);
-        }
-
-        rv = Value::with_size(POINTER_SIZE, false);
-        rv.write_usize(0, it - type_ids.begin());
-    }
-    else if( name == "type_name" )
-    {
-        const auto& ty_T = ty_params.tys.at(0);
-
-        static ::std::map<HIR::TypeRef, ::std::string>  s_type_names;
-        auto it = s_type_names.find(ty_T);
-        if( it == s_type_names.end() )
-        {
-            it = s_type_names.insert( ::std::make_pair(ty_T, FMT_STRING(ty_T)) ).first;
-        }
-
-        rv = Value::with_size(2*POINTER_SIZE, /*needs_alloc=*/true);
-        rv.write_ptr_ofs(0*POINTER_SIZE, 0, RelocationPtr::new_string(&it->second));
-        rv.write_usize(1*POINTER_SIZE, it->second.size());
-    }
-    else if( name == "discriminant_value" )
-    {
-        const auto& ty = ty_params.tys.at(0);
-        ValueRef val = args.at(0).deref(0, ty);
-
-        size_t fallback = SIZE_MAX;
-        size_t found_index = SIZE_MAX;
-        LOG_ASSERT(ty.inner_type == RawType::Composite, "discriminant_value " << ty);
-        const auto& dt = ty.composite_type();
-        for(size_t i = 0; i < dt.variants.size(); i ++)
-        {
-            const auto& var = dt.variants[i];
-            if( var.tag_data.size() == 0 )
-            {
-                // Only seen in Option<NonNull>
-                assert(fallback == SIZE_MAX);
-                fallback = i;
-            }
-            else
-            {
-                // Get offset to the tag
-                ::HIR::TypeRef  tag_ty;
-                size_t tag_ofs = ty.get_field_ofs(dt.tag_path.base_field, dt.tag_path.other_indexes, tag_ty);
-                // Compare
-                if( val.compare(tag_ofs, var.tag_data.data(), var.tag_data.size()) == 0 )
-                {
-                    found_index = i;
-                    break ;
-                }
-            }
-        }
-
-        if( found_index == SIZE_MAX )
-        {
-            LOG_ASSERT(fallback != SIZE_MAX, "Can't find variant of " << ty << " for " << val);
-            found_index = fallback;
-        }
-
-        rv = Value::new_usize(found_index);
-    }
-    else if( name == "atomic_fence" || name == "atomic_fence_acq" )
+// Frequently-called intrinsics, dispatched by name via `GlobalState::m_intrinsic_handlers`
+namespace {
+    bool intrinsic_atomic_fence(InterpreterThread& thread, Value& rv, const HIR::TypeRef& ret_ty, const RcString& name, const ::HIR::PathParams& ty_params, ::std::vector<Value> args)
     {
         rv = Value();
+        return true;
     }
-    else if( name == "atomic_store" || name == "atomic_store_relaxed" || name == "atomic_store_rel" )
+    bool intrinsic_atomic_store(InterpreterThread& thread, Value& rv, const HIR::TypeRef& ret_ty, const RcString& name, const ::HIR::PathParams& ty_params, ::std::vector<Value> args)
     {
         const auto& ty_T = ty_params.tys.at(0);
         auto data_ref = args.at(0).read_pointer_valref_mut(0, ty_T.get_size());
@@ -103,8 +33,9 @@ bool InterpreterThread::call_intrinsic(Value& rv, const HIR::TypeRef& ret_ty, co
 
         // TODO: Atomic side of this?
         data_ref.m_alloc.alloc().write_value(data_ref.m_offset, ::std::move(data_val));
+        return true;
     }
-    else if( name == "atomic_load" || name == "atomic_load_relaxed" || name == "atomic_load_acq" )
+    bool intrinsic_atomic_load(InterpreterThread& thread, Value& rv, const HIR::TypeRef& ret_ty, const RcString& name, const ::HIR::PathParams& ty_params, ::std::vector<Value> args)
     {
         const auto& ty_T = ty_params.tys.at(0);
         auto data_ref = args.at(0).read_pointer_valref_mut(0, ty_T.get_size());
@@ -112,8 +43,9 @@ bool InterpreterThread::call_intrinsic(Value& rv, const HIR::TypeRef& ret_ty, co
 
         // TODO: Atomic lock the allocation.
         rv = data_ref.m_alloc.alloc().read_value(data_ref.m_offset, ty_T.get_size());
+        return true;
     }
-    else if( name == "atomic_xadd" || name == "atomic_xadd_relaxed" )
+    bool intrinsic_atomic_xadd(InterpreterThread& thread, Value& rv, const HIR::TypeRef& ret_ty, const RcString& name, const ::HIR::PathParams& ty_params, ::std::vector<Value> args)
     {
         const auto& ty_T = ty_params.tys.at(0);
         auto data_ref = args.at(0).read_pointer_valref_mut(0, ty_T.get_size());
@@ -130,8 +62,9 @@ bool InterpreterThread::call_intrinsic(Value& rv, const HIR::TypeRef& ret_ty, co
         val_l.get().add( val_r.get() );
 
         val_l.get().write_to_value( data_ref.m_alloc.alloc(), data_ref.m_offset );
+        return true;
     }
-    else if( name == "atomic_xsub" || name == "atomic_xsub_relaxed" || name == "atomic_xsub_rel" )
+    bool intrinsic_atomic_xsub(InterpreterThread& thread, Value& rv, const HIR::TypeRef& ret_ty, const RcString& name, const ::HIR::PathParams& ty_params, ::std::vector<Value> args)
     {
         const auto& ty_T = ty_params.tys.at(0);
         auto data_ref = args.at(0).read_pointer_valref_mut(0, ty_T.get_size());
@@ -148,8 +81,9 @@ bool InterpreterThread::call_intrinsic(Value& rv, const HIR::TypeRef& ret_ty, co
         val_l.get().subtract( val_r.get() );
 
         val_l.get().write_to_value( data_ref.m_alloc.alloc(), data_ref.m_offset );
+        return true;
     }
-    else if( name == "atomic_xchg" || name == "atomic_xchg_acqrel"  )
+    bool intrinsic_atomic_xchg(InterpreterThread& thread, Value& rv, const HIR::TypeRef& ret_ty, const RcString& name, const ::HIR::PathParams& ty_params, ::std::vector<Value> args)
     {
         const auto& ty_T = ty_params.tys.at(0);
         auto data_ref = args.at(0).read_pointer_valref_mut(0, ty_T.get_size());
@@ -158,8 +92,9 @@ bool InterpreterThread::call_intrinsic(Value& rv, const HIR::TypeRef& ret_ty, co
         rv = data_ref.read_value(0, new_v.size());
         LOG_ASSERT(data_ref.m_alloc.is_alloc(), "Atomic operation with non-allocation pointer - " << data_ref);
         data_ref.m_alloc.alloc().write_value( data_ref.m_offset, std::move(new_v) );
+        return true;
     }
-    else if( name == "atomic_cxchg" || name == "atomic_cxchg_acq" )
+    bool intrinsic_atomic_cxchg(InterpreterThread& thread, Value& rv, const HIR::TypeRef& ret_ty, const RcString& name, const ::HIR::PathParams& ty_params, ::std::vector<Value> args)
     {
         const auto& ty_T = ty_params.tys.at(0);
         const auto& ret_dt = ret_ty.composite_type();
@@ -178,17 +113,16 @@ bool InterpreterThread::call_intrinsic(Value& rv, const HIR::TypeRef& ret_ty, co
             data_ref.m_alloc.alloc().write_value( data_ref.m_offset, std::move(new_v) );
         }
         rv.write_u8( ret_dt.fields.at(1).first, success ? 1 : 0 );
+        return true;
     }
-    else if( name == "transmute" )
+    bool intrinsic_transmute(InterpreterThread& thread, Value& rv, const HIR::TypeRef& ret_ty, const RcString& name, const ::HIR::PathParams& ty_params, ::std::vector<Value> args)
     {
         // Transmute requires the same size, so just copying the value works
         rv = ::std::move(args.at(0));
+        return true;
     }
-    else if( name == "assume" )
-    {
-        // Assume is a no-op which returns unit
-    }
-    else if( name == "offset" ) // Ensures pointer validity, pointer should never wrap around
+    // Ensures pointer validity, pointer should never wrap around
+    bool intrinsic_offset(InterpreterThread& thread, Value& rv, const HIR::TypeRef& ret_ty, const RcString& name, const ::HIR::PathParams& ty_params, ::std::vector<Value> args)
     {
         auto data_ref = args.at(0).read_pointer_valref_mut(0, 0);
 
@@ -204,6 +138,146 @@ bool InterpreterThread::call_intrinsic(Value& rv, const HIR::TypeRef& ret_ty, co
 
         rv = ::std::move(args.at(0));
         rv.write_ptr_ofs(0, new_ofs, data_ref.m_alloc);
+        return true;
+    }
+    bool intrinsic_copy_nonoverlapping(InterpreterThread& thread, Value& rv, const HIR::TypeRef& ret_ty, const RcString& name, const ::HIR::PathParams& ty_params, ::std::vector<Value> args)
+    {
+        //auto src_ofs = args.at(0).read_usize(0);
+        //auto src_alloc = args.at(0).get_relocation(0);
+        //auto dst_ofs = args.at(1).read_usize(0);
+        //auto dst_alloc = args.at(1).get_relocation(0);
+        size_t ent_count = args.at(2).read_usize(0);
+        size_t ent_size = ty_params.tys.at(0).get_size();
+        auto byte_count = ent_count * ent_size;
+        LOG_DEBUG("`copy_nonoverlapping`: byte_count=" << byte_count);
+
+        // A count of zero doesn't need to do any of the checks (TODO: Validate this rule)
+        if( byte_count > 0 )
+        {
+            auto src_vr = args.at(0).read_pointer_valref_mut(0, byte_count);
+            auto dst_vr = args.at(1).read_pointer_valref_mut(0, byte_count);
+
+            auto& dst_alloc = dst_vr.m_alloc;
+            LOG_ASSERT(dst_alloc, "Destination of copy* must be a memory allocation");
+            LOG_ASSERT(dst_alloc.is_alloc(), "Destination of copy* must be a memory allocation");
+
+            // TODO: is this inefficient?
+            auto src_val = src_vr.read_value(0, byte_count);
+            LOG_DEBUG("src_val = " << src_val);
+            dst_alloc.alloc().write_value(dst_vr.m_offset, ::std::move(src_val));
+        }
+        return true;
+    }
+}
+
+void GlobalState::register_intrinsic_handlers()
+{
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_fence"), &intrinsic_atomic_fence ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_fence_acq"), &intrinsic_atomic_fence ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_store"), &intrinsic_atomic_store ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_store_relaxed"), &intrinsic_atomic_store ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_store_rel"), &intrinsic_atomic_store ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_load"), &intrinsic_atomic_load ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_load_relaxed"), &intrinsic_atomic_load ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_load_acq"), &intrinsic_atomic_load ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_xadd"), &intrinsic_atomic_xadd ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_xadd_relaxed"), &intrinsic_atomic_xadd ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_xsub"), &intrinsic_atomic_xsub ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_xsub_relaxed"), &intrinsic_atomic_xsub ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_xsub_rel"), &intrinsic_atomic_xsub ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_xchg"), &intrinsic_atomic_xchg ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_xchg_acqrel"), &intrinsic_atomic_xchg ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_cxchg"), &intrinsic_atomic_cxchg ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("atomic_cxchg_acq"), &intrinsic_atomic_cxchg ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("transmute"), &intrinsic_transmute ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("offset"), &intrinsic_offset ));
+    m_intrinsic_handlers.insert(::std::make_pair( RcString::new_interned("copy_nonoverlapping"), &intrinsic_copy_nonoverlapping ));
+}
+
+bool InterpreterThread::call_intrinsic(Value& rv, const HIR::TypeRef& ret_ty, const RcString& name, const ::HIR::PathParams& ty_params, ::std::vector<Value> args)
+{
+    TRACE_FUNCTION_R(name, rv);
+    for(const auto& a : args)
+        LOG_DEBUG("#" << (&a - args.data()) << ": " << a);
+    {
+        auto it = m_global.m_intrinsic_handlers.find(name);
+        if( it != m_global.m_intrinsic_handlers.end() )
+        {
+            return it->second(*this, rv, ret_ty, name, ty_params, ::std::move(args));
+        }
+    }
+
+    if( name == "type_id" )
+    {
+        const auto& ty_T = ty_params.tys.at(0);
+        static ::std::vector<HIR::TypeRef>  type_ids;
+        auto it = ::std::find(type_ids.begin(), type_ids.end(), ty_T);
+        if( it == type_ids.end() )
+        {
+            it = type_ids.insert(it, ty_T);
+        }
+
+        rv = Value::with_size(POINTER_SIZE, false);
+        rv.write_usize(0, it - type_ids.begin());
+    }
+    else if( name == "type_name" )
+    {
+        const auto& ty_T = ty_params.tys.at(0);
+
+        static ::std::map<HIR::TypeRef, ::std::string>  s_type_names;
+        auto it = s_type_names.find(ty_T);
+        if( it == s_type_names.end() )
+        {
+            it = s_type_names.insert( ::std::make_pair(ty_T, FMT_STRING(ty_T)) ).first;
+        }
+
+        rv = Value::with_size(2*POINTER_SIZE, /*needs_alloc=*/true);
+        rv.write_ptr_ofs(0*POINTER_SIZE, 0, RelocationPtr::new_string(&it->second));
+        rv.write_usize(1*POINTER_SIZE, it->second.size());
+    }
+    else if( name == "discriminant_value" )
+    {
+        const auto& ty = ty_params.tys.at(0);
+        ValueRef val = args.at(0).deref(0, ty);
+
+        size_t fallback = SIZE_MAX;
+        size_t found_index = SIZE_MAX;
+        LOG_ASSERT(ty.inner_type == RawType::Composite, "discriminant_value " << ty);
+        const auto& dt = ty.composite_type();
+        for(size_t i = 0; i < dt.variants.size(); i ++)
+        {
+            const auto& var = dt.variants[i];
+            if( var.tag_data.size() == 0 )
+            {
+                // Only seen in Option<NonNull>
+                assert(fallback == SIZE_MAX);
+                fallback = i;
+            }
+            else
+            {
+                // Get offset to the tag
+                ::HIR::TypeRef  tag_ty;
+                size_t tag_ofs = ty.get_field_ofs(dt.tag_path.base_field, dt.tag_path.other_indexes, tag_ty);
+                // Compare
+                if( val.compare(tag_ofs, var.tag_data.data(), var.tag_data.size()) == 0 )
+                {
+                    found_index = i;
+                    break ;
+                }
+            }
+        }
+
+        if( found_index == SIZE_MAX )
+        {
+            LOG_ASSERT(fallback != SIZE_MAX, "Can't find variant of " << ty << " for " << val);
+            found_index = fallback;
+        }
+
+        rv = Value::new_usize(found_index);
+    }
+    else if( name == "assume" )
+    {
+        // Assume is a no-op which returns unit
     }
     else if( name == "arith_offset" )   // Doesn't check validity, and allows wrapping
     {
@@ -584,35 +658,6 @@ bool InterpreterThread::call_intrinsic(Value& rv, const HIR::TypeRef& ret_ty, co
         lhs.get().write_to_value(rv, 0);
     }
     // ----------------------------------------------------------------
-    // memcpy
-    else if( name == "copy_nonoverlapping" )
-    {
-        //auto src_ofs = args.at(0).read_usize(0);
-        //auto src_alloc = args.at(0).get_relocation(0);
-        //auto dst_ofs = args.at(1).read_usize(0);
-        //auto dst_alloc = args.at(1).get_relocation(0);
-        size_t ent_count = args.at(2).read_usize(0);
-        size_t ent_size = ty_params.tys.at(0).get_size();
-        auto byte_count = ent_count * ent_size;
-        LOG_DEBUG("`copy_nonoverlapping`: byte_count=" << byte_count);
-
-        // A count of zero doesn't need to do any of the checks (TODO: Validate this rule)
-        if( byte_count > 0 )
-        {
-            auto src_vr = args.at(0).read_pointer_valref_mut(0, byte_count);
-            auto dst_vr = args.at(1).read_pointer_valref_mut(0, byte_count);
-
-            auto& dst_alloc = dst_vr.m_alloc;
-            LOG_ASSERT(dst_alloc, "Destination of copy* must be a memory allocation");
-            LOG_ASSERT(dst_alloc.is_alloc(), "Destination of copy* must be a memory allocation");
-
-            // TODO: is this inefficient?
-            auto src_val = src_vr.read_value(0, byte_count);
-            LOG_DEBUG("src_val = " << src_val);
-            dst_alloc.alloc().write_value(dst_vr.m_offset, ::std::move(src_val));
-        }
-    }
-    // ----------------------------------------------------------------
     // Bit Twiddling
     // ---
     // cttz = CounT Trailing Zeroes
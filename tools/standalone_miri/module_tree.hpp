@@ -95,19 +95,19 @@ public:
         return *data_types.at(p);
     }
 
-    void iterate_statics(std::function<void(RcString name, const Static& s)> cb) const {
+    void iterate_statics(std::function<void(const RcString& name, const Static& s)> cb) const {
         for(const auto& e : this->statics)
         {
             cb(e.first, e.second);
         }
     }
-    void iterate_functions(std::function<void(RcString name, const Function& s)> cb) const {
+    void iterate_functions(std::function<void(const RcString& name, const Function& s)> cb) const {
         for(const auto& e : this->functions)
         {
             cb(e.first, e.second);
         }
     }
-    void iterate_composites(std::function<void(RcString name, const DataType& s)> cb) const {
+    void iterate_composites(std::function<void(const RcString& name, const DataType& s)> cb) const {
         for(const auto& e : this->data_types)
         {
             cb(e.first, *e.second);
@@ -0,0 +1,95 @@
+/*
+ * mrustc Standalone MIRI
+ * - by John Hodge (Mutabah)
+ *
+ * profiler.cpp
+ * - Execution profiler (per-function counts and sampled call stacks)
+ */
+#include "profiler.hpp"
+#include "module_tree.hpp"
+#include "debug.hpp"
+#include <fstream>
+#include <algorithm>
+
+Profiler::Profiler(unsigned sample_interval):
+    m_sample_interval(sample_interval > 0 ? sample_interval : 1),
+    m_until_sample(m_sample_interval)
+{
+}
+
+bool Profiler::count(const Function& fcn, unsigned bb_idx)
+{
+    auto& c = m_counts[&fcn];
+    if( c.blocks.empty() )
+    {
+        c.total = 0;
+        c.blocks.resize(fcn.m_mir.blocks.size());
+    }
+    c.total += 1;
+    c.blocks.at(bb_idx) += 1;
+
+    m_until_sample -= 1;
+    if( m_until_sample == 0 )
+    {
+        m_until_sample = m_sample_interval;
+        return true;
+    }
+    return false;
+}
+
+void Profiler::add_sample(const ::std::vector<const Function*>& frames)
+{
+    ::std::string   key;
+    for(const auto* f : frames)
+    {
+        if( !key.empty() )
+            key += ';';
+        // Spaces and semicolons are the separators in the collapsed format
+        for(char c : f->my_path)
+            key += (c == ';' || c == ' ' ? '_' : c);
+    }
+    m_stacks[key] += 1;
+}
+
+void Profiler::write(const ::std::string& path) const
+{
+    {
+        ::std::ofstream os(path);
+        if( !os.good() )
+        {
+            LOG_ERROR("Unable to open profile output " << path);
+        }
+        for(const auto& e : m_stacks)
+        {
+            os << e.first << " " << e.second << "\n";
+        }
+    }
+
+    // Per-function counts, most executed first
+    ::std::vector<::std::pair<const Function*, const FunctionCounts*>>  ents;
+    uint64_t    total = 0;
+    for(const auto& e : m_counts)
+    {
+        ents.push_back(::std::make_pair(e.first, &e.second));
+        total += e.second.total;
+    }
+    ::std::sort(ents.begin(), ents.end(), [](const auto& a, const auto& b){ return a.second->total > b.second->total; });
+
+    ::std::ofstream os(path + ".counts");
+    if( !os.good() )
+    {
+        LOG_ERROR("Unable to open profile output " << path << ".counts");
+    }
+    os << "# " << total << " instructions\n";
+    for(const auto& e : ents)
+    {
+        os << e.second->total << " " << e.first->my_path << "\n";
+        for(size_t i = 0; i < e.second->blocks.size(); i ++)
+        {
+            if( e.second->blocks[i] > 0 )
+            {
+                os << "\tBB" << i << " " << e.second->blocks[i] << "\n";
+            }
+        }
+    }
+}
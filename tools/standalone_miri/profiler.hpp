@@ -0,0 +1,43 @@
+/*
+ * mrustc Standalone MIRI
+ * - by John Hodge (Mutabah)
+ *
+ * profiler.hpp
+ * - Execution profiler (per-function counts and sampled call stacks)
+ */
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+
+struct Function;
+
+class Profiler
+{
+    // Number of instructions between call stack samples
+    unsigned    m_sample_interval;
+    unsigned    m_until_sample;
+
+    struct FunctionCounts {
+        uint64_t    total;
+        ::std::vector<uint64_t> blocks;
+    };
+    ::std::unordered_map<const Function*, FunctionCounts>   m_counts;
+    // Sample count for each call stack (outermost first, separated by `;`)
+    ::std::map<::std::string, uint64_t>  m_stacks;
+
+public:
+    Profiler(unsigned sample_interval);
+
+    /// Count an instruction (statement or terminator) in the given block, returns true if the call stack should be
+    /// sampled
+    bool count(const Function& fcn, unsigned bb_idx);
+    /// Record a call stack sample, `frames` is outermost first
+    void add_sample(const ::std::vector<const Function*>& frames);
+
+    /// Write collapsed stacks (`a;b;c <count>` lines, as used by flamegraph tools) to `path`, and per-function/block
+    /// counts to `path`.counts
+    void write(const ::std::string& path) const;
+};
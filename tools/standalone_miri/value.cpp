@@ -34,14 +34,46 @@ namespace {
     bool get_bit(const uint8_t* p, size_t i) {
         return (p[i/8] & (1 << (i%8))) != 0;
     }
+    /// Set/clear `len` bits starting at bit `ofs`
+    void fill_bits(uint8_t* p, size_t ofs, size_t len, bool v)
+    {
+        for( ; ofs % 8 != 0 && len > 0; ofs ++, len --)
+            set_bit(p, ofs, v);
+        ::std::memset(p + ofs/8, v ? 0xFF : 0x00, len / 8);
+        ofs += len & ~size_t(7);
+        for(len %= 8; len > 0; ofs ++, len --)
+            set_bit(p, ofs, v);
+    }
+    /// Check if all (or any, if `all` is false) of `len` bits starting at bit `ofs` are set
+    bool test_bits(const uint8_t* p, size_t ofs, size_t len, bool all)
+    {
+        for( ; ofs % 8 != 0 && len > 0; ofs ++, len --)
+            if( get_bit(p, ofs) != all )
+                return !all;
+        for( ; len >= 64; ofs += 64, len -= 64)
+        {
+            uint64_t w;
+            ::std::memcpy(&w, p + ofs/8, sizeof(w));
+            if( w != (all ? ~uint64_t(0) : 0) )
+                return !all;
+        }
+        for( ; len >= 8; ofs += 8, len -= 8)
+            if( p[ofs/8] != (all ? 0xFF : 0x00) )
+                return !all;
+        for( ; len > 0; ofs ++, len --)
+            if( get_bit(p, ofs) != all )
+                return !all;
+        return all;
+    }
     void copy_bits(uint8_t* dst, size_t dst_ofs, const uint8_t* src, size_t src_ofs,  size_t len)
     {
-        // Even number of bytes, fast copy
-        if( dst_ofs % 8 == 0 && src_ofs % 8 == 0 && len % 8 == 0 )
+        // Byte-aligned, fast copy
+        if( dst_ofs % 8 == 0 && src_ofs % 8 == 0 )
         {
-            for(size_t i = 0; i < len/8; i ++)
+            ::std::memcpy(dst + dst_ofs/8, src + src_ofs/8, len/8);
+            for(size_t i = len & ~size_t(7); i < len; i ++)
             {
-                dst[dst_ofs/8 + i] = src[src_ofs/8 + i];
+                set_bit( dst, dst_ofs+i, get_bit(src, src_ofs+i) );
             }
         }
         else
@@ -88,19 +120,57 @@ bool FfiPointerInner::is_valid_read(size_t o, size_t s) const
 
 uint64_t Allocation::s_next_index = 0;
 
-AllocationHandle Allocation::new_alloc(size_t size, ::std::string tag)
+namespace {
+    // Released allocations kept for reuse, indexed by size in QWORDS
+    // - Most allocations are short-lived locals/temporaries, so this avoids most of the heap traffic from calls
+    const size_t    POOL_MAX_QWORDS = 64;
+    const size_t    POOL_MAX_ENTRIES = 256;
+    ::std::vector<Allocation*>  s_alloc_pool[POOL_MAX_QWORDS+1];
+}
+
+AllocationHandle Allocation::new_alloc(size_t size, RcString tag)
 {
-    Allocation* rv = new Allocation();
+    size_t n_qwords = (size + 8-1) / 8;
+    Allocation* rv;
+    if( n_qwords <= POOL_MAX_QWORDS && !s_alloc_pool[n_qwords].empty() )
+    {
+        // Vectors are already the right size, and were cleared by `release`
+        rv = s_alloc_pool[n_qwords].back();
+        s_alloc_pool[n_qwords].pop_back();
+    }
+    else
+    {
+        rv = new Allocation();
+        rv->m_data.resize( n_qwords );    // QWORDS
+        rv->m_mask.resize( n_qwords );    // bitmap bytes
+        rv->m_reloc_mask.resize( n_qwords );
+    }
     rv->m_index = s_next_index++;
     rv->m_tag = ::std::move(tag);
     rv->refcount = 1;
     rv->m_size = size;
-    rv->m_data.resize( (size + 8-1) / 8 );    // QWORDS
-    rv->m_mask.resize( (size + 8-1) / 8 );    // bitmap bytes
     //LOG_DEBUG(rv << " ALLOC");
     LOG_DEBUG(rv);
     return AllocationHandle(rv);
 }
+void Allocation::release(Allocation* alloc)
+{
+    size_t n_qwords = alloc->m_data.size();
+    if( n_qwords <= POOL_MAX_QWORDS && s_alloc_pool[n_qwords].size() < POOL_MAX_ENTRIES )
+    {
+        alloc->is_freed = false;
+        alloc->m_tag = RcString();
+        alloc->relocations.clear();
+        ::std::fill(alloc->m_data.begin(), alloc->m_data.end(), 0);
+        ::std::fill(alloc->m_mask.begin(), alloc->m_mask.end(), 0);
+        ::std::fill(alloc->m_reloc_mask.begin(), alloc->m_reloc_mask.end(), 0);
+        s_alloc_pool[n_qwords].push_back(alloc);
+    }
+    else
+    {
+        delete alloc;
+    }
+}
 AllocationHandle::AllocationHandle(const AllocationHandle& x):
     m_ptr(x.m_ptr)
 {
@@ -120,7 +190,7 @@ AllocationHandle::~AllocationHandle()
         //LOG_DEBUG(m_ptr << " REF-- " << m_ptr->refcount);
         if(m_ptr->refcount == 0)
         {
-            delete m_ptr;
+            Allocation::release(m_ptr);
         }
         m_ptr = nullptr;
     }
@@ -418,6 +488,15 @@ void Allocation::resize(size_t new_size)
     this->m_size = new_size;
     this->m_data.resize( (new_size + 8-1) / 8 );
     this->m_mask.resize( (new_size + 8-1) / 8 );
+    this->m_reloc_mask.resize( (new_size + 8-1) / 8 );
+    // Drop relocations that are now out of range (and clear their bits, in case the allocation grows again)
+    auto it = this->find_reloc(new_size);
+    for(auto it2 = it; it2 != this->relocations.end(); ++it2)
+    {
+        if( it2->slot_ofs / 8 < this->m_reloc_mask.size() )
+            set_bit(this->m_reloc_mask.data(), it2->slot_ofs, false);
+    }
+    this->relocations.erase(it, this->relocations.end());
 }
 
 void Allocation::check_bytes_valid(size_t ofs, size_t size) const
@@ -425,22 +504,16 @@ void Allocation::check_bytes_valid(size_t ofs, size_t size) const
     if( !in_bounds(ofs, size, this->size()) ) {
         LOG_FATAL("Out of range - " << ofs << "+" << size << " > " << this->size());
     }
-    for(size_t i = ofs; i < ofs + size; i++)
+    if( !test_bits(this->m_mask.data(), ofs, size, /*all=*/true) )
     {
-        if( !(this->m_mask[i/8] & (1 << (i%8))) )
-        {
-            LOG_ERROR("Invalid bytes in value - " << ofs << "+" << size << " - " << *this);
-            throw "ERROR";
-        }
+        LOG_ERROR("Invalid bytes in value - " << ofs << "+" << size << " - " << *this);
+        throw "ERROR";
     }
 }
 void Allocation::mark_bytes_valid(size_t ofs, size_t size)
 {
     assert( ofs+size <= this->m_mask.size() * 8 );
-    for(size_t i = ofs; i < ofs + size; i++)
-    {
-        this->m_mask[i/8] |= (1 << (i%8));
-    }
+    fill_bits(this->m_mask.data(), ofs, size, true);
 }
 Value Allocation::read_value(size_t ofs, size_t size) const
 {
@@ -451,26 +524,16 @@ Value Allocation::read_value(size_t ofs, size_t size) const
     LOG_ASSERT( in_bounds(ofs, size, this->size()), "Read out of bounds (" << ofs << "+" << size << " > " << this->size() << ")" );
 
     // Determine if this can become an inline allocation.
-    bool has_reloc = false;
-    for(const auto& r : this->relocations)
-    {
-        if( ofs <= r.slot_ofs && r.slot_ofs < ofs + size )
-        {
-            // NOTE: A relocation at offset zero is allowed
-            if( r.slot_ofs == ofs )
-                continue ;
-            has_reloc = true;
-        }
-    }
+    // NOTE: A relocation at offset zero is allowed
+    auto reloc_start = this->find_reloc(ofs);
+    auto reloc_end = this->find_reloc(ofs + size);
+    bool has_reloc = reloc_end - reloc_start > (reloc_start != reloc_end && reloc_start->slot_ofs == ofs ? 1 : 0);
     rv = Value::with_size(size, has_reloc);
     rv.write_bytes(0, this->data_ptr() + ofs, size);
 
-    for(const auto& r : this->relocations)
+    for(auto it = reloc_start; it != reloc_end; ++it)
     {
-        if( ofs <= r.slot_ofs && r.slot_ofs < ofs + size )
-        {
-            rv.set_reloc(r.slot_ofs - ofs, /*r.size*/POINTER_SIZE, r.backing_alloc);
-        }
+        rv.set_reloc(it->slot_ofs - ofs, /*r.size*/POINTER_SIZE, it->backing_alloc);
     }
     // Copy the mask bits
     copy_bits(rv.get_mask_mut(), 0, m_mask.data(), ofs, size);
@@ -526,8 +589,7 @@ void Allocation::write_value(size_t ofs, Value v)
             for(auto& r : new_relocs)
             {
                 //LOG_TRACE("Insert " << r.backing_alloc);
-                r.slot_ofs += ofs;
-                this->relocations.push_back( ::std::move(r) );
+                this->insert_reloc(r.slot_ofs + ofs, ::std::move(r.backing_alloc));
             }
         }
 
@@ -562,19 +624,7 @@ void Allocation::write_bytes(size_t ofs, const void* src, size_t count)
 
 
     // - Remove any relocations already within this region
-    auto& this_relocs = this->relocations;
-    for(auto it = this_relocs.begin(); it != this_relocs.end(); )
-    {
-        if( ofs <= it->slot_ofs && it->slot_ofs < ofs + count)
-        {
-            //LOG_TRACE("Delete " << it->backing_alloc);
-            it = this_relocs.erase(it);
-        }
-        else 
-        {
-            ++it;
-        }
-    }
+    this->clear_relocs(ofs, count);
 
     ::std::memcpy(this->data_ptr() + ofs, src, count);
     mark_bytes_valid(ofs, count);
@@ -590,20 +640,29 @@ void Allocation::set_reloc(size_t ofs, size_t len, RelocationPtr reloc)
     LOG_ASSERT(ofs % POINTER_SIZE == 0, "Allocation::set_reloc(" << ofs << ", " << len << ", " << reloc << ")");
     LOG_ASSERT(len == POINTER_SIZE, "Allocation::set_reloc(" << ofs << ", " << len << ", " << reloc << ")");
     // Delete any existing relocation at this position
-    for(auto it = this->relocations.begin(); it != this->relocations.end();)
-    {
-        if( ofs <= it->slot_ofs && it->slot_ofs < ofs + len )
-        {
-            // Slot starts in this updated region
-            // - TODO: Split in half?
-            it = this->relocations.erase(it);
-            continue ;
-        }
-        // TODO: What if the slot ends in the new region?
-        // What if the new region is in the middle of the slot
-        ++ it;
-    }
-    this->relocations.push_back(Relocation { ofs, /*len,*/ ::std::move(reloc) });
+    // - TODO: What if the slot ends in the new region?
+    // What if the new region is in the middle of the slot
+    this->clear_relocs(ofs, len);
+    this->insert_reloc(ofs, ::std::move(reloc));
+}
+void Allocation::clear_relocs(size_t ofs, size_t len)
+{
+    // Fast path: No relocations in this range
+    if( !test_bits(this->m_reloc_mask.data(), ofs, len, /*all=*/false) )
+        return ;
+    auto start = this->find_reloc(ofs);
+    auto end = this->find_reloc(ofs + len);
+    for(auto it = start; it != end; ++it)
+        set_bit(this->m_reloc_mask.data(), it->slot_ofs, false);
+    this->relocations.erase(start, end);
+}
+void Allocation::insert_reloc(size_t ofs, RelocationPtr reloc)
+{
+    LOG_ASSERT(ofs < this->size(), "Allocation::insert_reloc(" << ofs << ") out of range - " << this->size());
+    auto it = this->find_reloc(ofs);
+    assert(it == this->relocations.end() || it->slot_ofs != ofs);
+    this->relocations.insert(it, Relocation { ofs, /*len,*/ ::std::move(reloc) });
+    set_bit(this->m_reloc_mask.data(), ofs, true);
 }
 ::std::ostream& operator<<(::std::ostream& os, const Allocation& x)
 {
@@ -669,7 +728,14 @@ Value::Value(::HIR::TypeRef ty)
 
     // Fallback: Make a new allocation
     //LOG_TRACE(" Creating allocation for " << ty);
-    new(&m_inner.alloc) Inner::Alloc( Allocation::new_alloc(size, FMT_STRING(ty)) );
+    // - Type names are cached, as formatting them was a significant part of the cost of calls
+    static ::std::map<::HIR::TypeRef, RcString> s_type_tags;
+    auto it = s_type_tags.find(ty);
+    if( it == s_type_tags.end() )
+    {
+        it = s_type_tags.insert(::std::make_pair(ty, RcString(FMT_STRING(ty)))).first;
+    }
+    new(&m_inner.alloc) Inner::Alloc( Allocation::new_alloc(size, it->second) );
     assert(m_inner.is_alloc);
 }
 Value Value::with_size(size_t size, bool have_allocation)
@@ -677,7 +743,7 @@ Value Value::with_size(size_t size, bool have_allocation)
     Value   rv;
     if(have_allocation || size > sizeof(m_inner.direct.data))
     {
-        new(&rv.m_inner.alloc) Inner::Alloc( Allocation::new_alloc(size, FMT_STRING("with_size(" << size << ")")) );
+        new(&rv.m_inner.alloc) Inner::Alloc( Allocation::new_alloc(size, "with_size") );
     }
     else
     {
@@ -739,7 +805,7 @@ void Value::create_allocation(std::string loc)
 {
     LOG_DEBUG(loc << " - Creating allocation for " << *this);
     assert(!m_inner.is_alloc);
-    auto new_alloc = Allocation::new_alloc(m_inner.direct.size, "create_allocation:"+loc);   // TODO: Provide a better name?
+    auto new_alloc = Allocation::new_alloc(m_inner.direct.size, RcString("create_allocation:"+loc));   // TODO: Provide a better name?
     auto& direct = m_inner.direct;
     if( direct.size > 0 )
         new_alloc->m_mask[0] = direct.mask[0];
@@ -8,12 +8,14 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>   // lower_bound
 #include <memory>
 #include <cstdint>
 #include <cstring>	// memcpy
 #include <cassert>
 
 #include "debug.hpp"
+#include "../../src/include/rc_string.hpp"
 #include "u128.hpp"
 
 namespace HIR {
@@ -319,7 +321,7 @@ class Allocation:
 
     static uint64_t s_next_index;
 
-    ::std::string   m_tag;
+    RcString    m_tag;
     size_t  refcount;
     size_t  m_size;
     uint64_t m_index;
@@ -327,30 +329,36 @@ class Allocation:
     bool is_freed = false;
 
     ::std::vector<uint64_t> m_data;
+    /// Bitmap of offsets that have an entry in `relocations` (same layout as `m_mask`)
+    ::std::vector<uint8_t> m_reloc_mask;
 public:
     ::std::vector<uint8_t> m_mask;
+    /// Relocations sorted by `slot_ofs` (only modified through `set_reloc`/`write_*`)
     ::std::vector<Relocation>   relocations;
 public:
     virtual ~Allocation() {}
-    static AllocationHandle new_alloc(size_t size, ::std::string tag);
+    static AllocationHandle new_alloc(size_t size, RcString tag);
+private:
+    // Called when the last handle is dropped, keeps small allocations for reuse by `new_alloc`
+    static void release(Allocation* alloc);
+public:
 
     const uint8_t* data_ptr() const { return reinterpret_cast<const uint8_t*>(this->m_data.data()); }
           uint8_t* data_ptr()       { return reinterpret_cast<      uint8_t*>(this->m_data.data()); }
     size_t size() const { return m_size; }
-    const ::std::string& tag() const { return m_tag; }
+    const RcString& tag() const { return m_tag; }
 
     RelocationPtr get_relocation(size_t ofs) const override {
-        for(const auto& r : relocations) {
-            if(r.slot_ofs == ofs)
-                return r.backing_alloc;
-        }
-        return RelocationPtr();
+        // Most reads are of slots without a relocation, so check the bitmap before searching
+        if( ofs >= m_size || !(m_reloc_mask[ofs/8] & (1 << (ofs%8))) )
+            return RelocationPtr();
+        return find_reloc(ofs)->backing_alloc;
     }
     void mark_as_freed() {
         is_freed = true;
         relocations.clear();
-        for(auto& v : m_mask)
-            v = 0;
+        ::std::fill(m_mask.begin(), m_mask.end(), 0);
+        ::std::fill(m_reloc_mask.begin(), m_reloc_mask.end(), 0);
     }
 
     void resize(size_t new_size);
@@ -367,6 +375,18 @@ public:
 
     void set_reloc(size_t ofs, size_t len, RelocationPtr reloc);
     friend ::std::ostream& operator<<(::std::ostream& os, const Allocation* x);
+private:
+    /// Get the first relocation at or after `ofs`
+    ::std::vector<Relocation>::const_iterator find_reloc(size_t ofs) const {
+        return ::std::lower_bound(relocations.begin(), relocations.end(), ofs, [](const Relocation& r, size_t o){ return r.slot_ofs < o; });
+    }
+    ::std::vector<Relocation>::iterator find_reloc(size_t ofs) {
+        return ::std::lower_bound(relocations.begin(), relocations.end(), ofs, [](const Relocation& r, size_t o){ return r.slot_ofs < o; });
+    }
+    /// Remove all relocations within `ofs`+`len`
+    void clear_relocs(size_t ofs, size_t len);
+    /// Add a relocation (the slot must be empty)
+    void insert_reloc(size_t ofs, RelocationPtr reloc);
 };
 extern ::std::ostream& operator<<(::std::ostream& os, const Allocation& x);
 